@@ -0,0 +1,48 @@
+// Graph ingestion cost at various ring sizes, with and without the
+// level-of-detail pyramid.
+
+#include <cstddef>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+namespace {
+dbgvis::GraphConfig ConfigFor(const benchmark::State& state) {
+    dbgvis::GraphConfig config;
+    config.max_samples = static_cast<size_t>(state.range(0));
+    config.level_of_detail = state.range(1) != 0;
+    return config;
+}
+
+// Starts with a full ring so every push overwrites and evicts.
+void BM_GraphPush(benchmark::State& state) {
+    dbgvis::DebugVisualizer::Graph graph(ConfigFor(state));
+    for (size_t i = 0; i < graph.config().max_samples; ++i) {
+        graph.push(static_cast<float>(i % 97));
+    }
+    float sample = 0.0f;
+    for (auto _ : state) {
+        graph.push(sample);
+        sample = sample > 100.0f ? 0.0f : sample + 1.5f;
+    }
+    benchmark::DoNotOptimize(graph.max_sample());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GraphPush)->ArgsProduct({{64, 1024, 16384, 1 << 20}, {0, 1}});
+
+void BM_GraphAddSamples(benchmark::State& state) {
+    dbgvis::DebugVisualizer::Graph graph(ConfigFor(state));
+    std::vector<float> block(1024);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<float>(i % 97);
+    }
+    for (auto _ : state) {
+        graph.add_samples(block.data(), block.size());
+    }
+    benchmark::DoNotOptimize(graph.max_sample());
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(block.size()));
+}
+BENCHMARK(BM_GraphAddSamples)->ArgsProduct({{64, 1024, 16384, 1 << 20}, {0, 1}});
+}  // namespace
@@ -0,0 +1,96 @@
+// Per-frame cost of drawing a tab with many keys, in a Dear ImGui context
+// without a window or renderer.
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <imgui/imgui.h>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+namespace {
+class HeadlessContext {
+public:
+    HeadlessContext() {
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+        io.DeltaTime = 1.0f / 60.0f;
+        io.Fonts->Build();
+    }
+    ~HeadlessContext() {
+        ImGui::DestroyContext();
+    }
+
+    void frame(dbgvis::DebugVisualizer& visualizer) {
+        ImGui::NewFrame();
+        visualizer.render();
+        ImGui::Render();
+    }
+};
+
+// The default tab is the one on screen.
+void BM_RenderScalars(benchmark::State& state) {
+    HeadlessContext context;
+    dbgvis::DebugVisualizer visualizer;
+    dbgvis::DebugVisualizer::Tab& tab = visualizer.default_tab();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        tab.update_value("key " + std::to_string(i), i);
+    }
+    int64_t frame = 0;
+    for (auto _ : state) {
+        // Every key on screen changes, as with values published each frame.
+        for (int64_t i = 0; i < 64 && i < state.range(0); ++i) {
+            tab.update_value("key " + std::to_string(i), frame + i);
+        }
+        context.frame(visualizer);
+        ++frame;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RenderScalars)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+void BM_RenderGraphs(benchmark::State& state) {
+    HeadlessContext context;
+    dbgvis::DebugVisualizer visualizer;
+    dbgvis::DebugVisualizer::Tab& tab = visualizer.default_tab();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        const std::string key = "graph " + std::to_string(i);
+        for (int s = 0; s < 240; ++s) {
+            tab.push_graph_sample(key, static_cast<float>((s * 7 + i) % 50));
+        }
+    }
+    for (auto _ : state) {
+        context.frame(visualizer);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RenderGraphs)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// 400 graphs, the first range(0) of which take a sample every frame; rows
+// on screen without a new sample replay the geometry they were drawn with.
+void BM_RenderChangingGraphs(benchmark::State& state) {
+    HeadlessContext context;
+    dbgvis::DebugVisualizer visualizer;
+    dbgvis::DebugVisualizer::Tab& tab = visualizer.default_tab();
+    std::vector<std::string> keys;
+    for (int i = 0; i < 400; ++i) {
+        keys.push_back("graph " + std::to_string(1000 + i));
+        for (int s = 0; s < 240; ++s) {
+            tab.push_graph_sample(keys.back(), static_cast<float>((s * 7 + i) % 50));
+        }
+    }
+    int64_t frame = 0;
+    for (auto _ : state) {
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            tab.push_graph_sample(keys[static_cast<size_t>(i)], static_cast<float>((frame + i) % 50));
+        }
+        context.frame(visualizer);
+        ++frame;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RenderChangingGraphs)->Arg(0)->Arg(40)->Arg(400)->Unit(benchmark::kMicrosecond);
+}  // namespace
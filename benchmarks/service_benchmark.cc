@@ -0,0 +1,200 @@
+// Producer-side publish cost and service-side drain cost of the background
+// visualizer, measured through the public dbgvis:: API.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+void StartService(size_t flush_threads = 0) {
+    dbgvis::DebugVisualizerAppOptions options;
+    options.headless = true;
+    options.flush_threads = flush_threads;
+    // A short tick keeps the queue drained while producers run flat out and
+    // bounds the idle time inside each drain measurement.
+    options.headless_update_hz = 10000.0f;
+    dbgvis::StartBackgroundVisualizer(options);
+    while (!dbgvis::IsBackgroundVisualizerRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Runs on the service thread once every update posted before it has been
+// applied; structure builders execute during the flush.
+void WaitForDrain() {
+    std::atomic<bool> applied{false};
+    dbgvis::structure("Bench", "fence", [&applied](dbgvis::StructureBuilder&) {
+        applied.store(true, std::memory_order_release);
+    });
+    while (!applied.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+// Per-call latencies of one thread, reported as percentiles averaged over
+// the benchmark's threads.
+class LatencyRecorder {
+public:
+    void add(Clock::duration elapsed) {
+        samples_.push_back(
+            static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    void report(benchmark::State& state) {
+        if (samples_.empty()) {
+            return;
+        }
+        std::sort(samples_.begin(), samples_.end());
+        const auto percentile = [&](double p) {
+            return static_cast<double>(samples_[static_cast<size_t>(p * static_cast<double>(samples_.size() - 1))]);
+        };
+        state.counters["p50_ns"] = benchmark::Counter(percentile(0.50), benchmark::Counter::kAvgThreads);
+        state.counters["p99_ns"] = benchmark::Counter(percentile(0.99), benchmark::Counter::kAvgThreads);
+        state.counters["p999_ns"] = benchmark::Counter(percentile(0.999), benchmark::Counter::kAvgThreads);
+        state.counters["max_ns"] = benchmark::Counter(static_cast<double>(samples_.back()), benchmark::Counter::kAvgThreads);
+    }
+
+private:
+    std::vector<uint32_t> samples_;
+};
+
+template <typename Publish>
+void RunPublish(benchmark::State& state, Publish publish) {
+    if (state.thread_index() == 0) {
+        StartService();
+    }
+    const std::string key = "key " + std::to_string(state.thread_index());
+    LatencyRecorder latency;
+    int64_t i = 0;
+    for (auto _ : state) {
+        const auto begin = Clock::now();
+        publish(key, i++);
+        latency.add(Clock::now() - begin);
+    }
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        dbgvis::ShutdownBackgroundVisualizer();
+    }
+}
+
+void BM_PublishValue(benchmark::State& state) {
+    RunPublish(state, [](const std::string& key, int64_t i) {
+        dbgvis::value("Bench", key, i);
+    });
+}
+BENCHMARK(BM_PublishValue)->ThreadRange(1, 64)->UseRealTime();
+
+void BM_PublishGraphSample(benchmark::State& state) {
+    RunPublish(state, [](const std::string& key, int64_t i) {
+        dbgvis::graph_sample("Bench", key, static_cast<float>(i));
+    });
+}
+BENCHMARK(BM_PublishGraphSample)->ThreadRange(1, 64)->UseRealTime();
+
+void BM_PublishStructure(benchmark::State& state) {
+    RunPublish(state, [](const std::string& key, int64_t i) {
+        dbgvis::structure("Bench", key, [i](dbgvis::StructureBuilder& builder) {
+            builder.field("i", i);
+            builder.nested("inner").field("half", i / 2);
+        });
+    });
+}
+BENCHMARK(BM_PublishStructure)->ThreadRange(1, 64)->UseRealTime();
+
+// No queue at all: one relaxed add on the thread's shard.
+void BM_CounterAdd(benchmark::State& state) {
+    static dbgvis::Counter counter("Bench", "counter");
+    RunPublish(state, [](const std::string&, int64_t) {
+        counter.add();
+    });
+}
+BENCHMARK(BM_CounterAdd)->ThreadRange(1, 64)->UseRealTime();
+
+// Most calls only add to the thread-local sketch.
+void BM_PublishHistogram(benchmark::State& state) {
+    RunPublish(state, [](const std::string& key, int64_t i) {
+        dbgvis::histogram("Bench", key, static_cast<double>(i % 1000 + 1));
+    });
+}
+BENCHMARK(BM_PublishHistogram)->ThreadRange(1, 64)->UseRealTime();
+
+// One empty zone per iteration; most calls only append to the thread-local
+// buffer.
+void BM_Scope(benchmark::State& state) {
+    RunPublish(state, [](const std::string&, int64_t) {
+        DBGVIS_SCOPE("Bench/Zone");
+    });
+}
+BENCHMARK(BM_Scope)->ThreadRange(1, 64)->UseRealTime();
+
+// Time from releasing a stalled service thread to it having applied
+// range(0) queued updates spread over 1024 keys in `tabs` tabs.
+void RunFlush(benchmark::State& state, size_t tabs, size_t flush_threads) {
+    StartService(flush_threads);
+    const int64_t count = state.range(0);
+    std::vector<std::string> tab_ids;
+    for (size_t t = 0; t < tabs; ++t) {
+        tab_ids.push_back(tabs == 1 ? std::string("Bench") : "Bench " + std::to_string(t));
+    }
+    std::vector<std::string> keys;
+    for (int k = 0; k < 1024; ++k) {
+        keys.push_back("key " + std::to_string(k));
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        // Hold the service inside a flush so every update below is queued
+        // for the next one.
+        std::atomic<bool> stalled{false};
+        std::atomic<bool> release{false};
+        dbgvis::structure("Bench", "gate", [&](dbgvis::StructureBuilder&) {
+            stalled.store(true, std::memory_order_release);
+            while (!release.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        });
+        while (!stalled.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        for (int64_t i = 0; i < count; ++i) {
+            const size_t k = static_cast<size_t>(i) % keys.size();
+            const std::string& tab = tab_ids[k % tab_ids.size()];
+            if (i % 2 == 0) {
+                dbgvis::value(tab, keys[k], i);
+            } else {
+                dbgvis::graph_sample(tab, keys[k], static_cast<float>(i));
+            }
+        }
+        state.ResumeTiming();
+        release.store(true, std::memory_order_release);
+        WaitForDrain();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    dbgvis::ShutdownBackgroundVisualizer();
+}
+
+void BM_FlushUpdates(benchmark::State& state) {
+    RunFlush(state, 1, 0);
+}
+BENCHMARK(BM_FlushUpdates)->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// The same updates over 16 tabs, with range(1) flush workers.
+void BM_FlushUpdatesAcrossTabs(benchmark::State& state) {
+    RunFlush(state, 16, static_cast<size_t>(state.range(1)));
+}
+BENCHMARK(BM_FlushUpdatesAcrossTabs)
+    ->ArgsProduct({{1 << 14, 1 << 17}, {0, 1, 3, 7}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+}  // namespace
@@ -21,11 +21,28 @@
 
 #pragma once
 
+// Build with DBGVIS_ENABLED=0 (bazel build --define=dbgvis=disabled) to turn
+// the dbgvis:: publishing API into inline no-ops and drop the ImGui/GL
+// dependencies. Only the free functions below are compiled out; code that
+// uses DebugVisualizer or DebugVisualizerApp directly needs the enabled build.
+#ifndef DBGVIS_ENABLED
+#define DBGVIS_ENABLED 1
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <initializer_list>
+#include <limits>
 #include <memory>
 #include <map>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -39,22 +56,82 @@ struct StructureNode {
     std::vector<StructureNode> children;
 };
 
-class StructureBuilder {
+class StructureBuilder;
+
+// Storage behind a published structure: one flat node vector linked by
+// index, with released slots kept on a free list. StructureBuilder matches
+// each call against the previous contents and updates values in place, so
+// republishing the same shape allocates nothing.
+class StructureTree {
 public:
-    explicit StructureBuilder(std::vector<StructureNode>* nodes);
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Node {
+        std::string label;
+        std::optional<ScalarValue> value;
+        bool branch = false;
+        uint32_t first_child = kNone;
+        uint32_t next_sibling = kNone;
+        uint64_t stamp = 0;
+        // Formatted text as drawn, rebuilt when the value changes.
+        mutable std::string text;
+        mutable bool dirty = true;
+    };
+
+    StructureTree();
+
+    // Runs `builder` over the tree, then releases every node it did not emit.
+    void update(const std::function<void(StructureBuilder&)>& builder);
+    void clear();
+
+    const Node& node(uint32_t index) const;
+    const Node& root() const;
+    bool empty() const;
+    // Live nodes, not counting the root.
+    size_t size() const;
+
+    StructureNode snapshot() const;
+
+private:
+    friend class StructureBuilder;
+
+    uint32_t allocate();
+    void release(uint32_t index);
+    void sweep();
+    StructureNode snapshot_node(uint32_t index) const;
+
+    std::vector<Node> nodes_;
+    uint32_t free_ = kNone;
+    size_t live_ = 0;
+    uint64_t stamp_ = 0;
+    std::vector<uint32_t> pending_;
+    std::vector<uint32_t> released_;
+};
 
-    void field(const std::string& label, int value);
-    void field(const std::string& label, int64_t value);
-    void field(const std::string& label, float value);
-    void field(const std::string& label, double value);
-    void field(const std::string& label, bool value);
-    void field(const std::string& label, std::string value);
-    void field(const std::string& label, const char* value);
+class StructureBuilder {
+public:
+    void field(std::string_view label, int value);
+    void field(std::string_view label, int64_t value);
+    void field(std::string_view label, float value);
+    void field(std::string_view label, double value);
+    void field(std::string_view label, bool value);
+    void field(std::string_view label, std::string value);
+    void field(std::string_view label, const char* value);
 
-    StructureBuilder nested(const std::string& label);
+    StructureBuilder nested(std::string_view label);
 
 private:
-    std::vector<StructureNode>* nodes_;
+    friend class StructureTree;
+
+    StructureBuilder(StructureTree* tree, uint32_t parent);
+
+    void put(std::string_view label, ScalarValue value);
+    uint32_t match(std::string_view label, bool branch);
+
+    StructureTree* tree_;
+    uint32_t parent_;
+    uint32_t prev_;
+    uint32_t cursor_;
 };
 
 struct GraphConfig {
@@ -62,9 +139,135 @@ struct GraphConfig {
     bool auto_scale = true;
     float manual_min = 0.0f;
     float manual_max = 1.0f;
+    // Keep a min/max-per-bucket pyramid next to the raw samples so long
+    // histories render at screen resolution without losing peaks.
+    bool level_of_detail = false;
+};
+
+struct TimeSeriesConfig {
+    // One label per value column. Left empty, the first sample fixes the
+    // column count and the columns are labelled by index.
+    std::vector<std::string> series;
+    // Seconds of history kept behind the newest sample; 0 keeps rows until
+    // max_samples is reached.
+    double time_window = 10.0;
+    size_t max_samples = 4096;
+    bool auto_scale = true;
+    float manual_min = 0.0f;
+    float manual_max = 1.0f;
+};
+
+struct HistogramConfig {
+    // Quantiles are reported within this relative error of a recorded value.
+    double relative_accuracy = 0.01;
+    // Positive values are clamped into [min_value, max_value]; zero and
+    // negative values share one bucket that reads as 0. The two bounds fix
+    // the most buckets a sketch can ever hold.
+    double min_value = 1e-6;
+    double max_value = 1e9;
+};
+
+// Log-bucketed quantile sketch (DDSketch): bucket i counts values in
+// (gamma^(i-1), gamma^i], with gamma = (1 + a) / (1 - a) for relative
+// accuracy a. Buckets are stored densely over the range seen so far, so
+// memory depends on the spread of the values, never on how many there are.
+// Sketches with the same config merge exactly.
+class QuantileSketch {
+public:
+    QuantileSketch();
+    explicit QuantileSketch(const HistogramConfig& config);
+
+    const HistogramConfig& config() const;
+    bool same_config(const HistogramConfig& config) const;
+
+    void add(double value, uint64_t count = 1);
+    // False, leaving this sketch unchanged, when the configs differ.
+    bool merge(const QuantileSketch& other);
+    void clear();
+
+    uint64_t count() const;
+    bool empty() const;
+    double sum() const;
+    double mean() const;
+    double min() const;
+    double max() const;
+    // q in [0, 1]; 0 when empty.
+    double quantile(double q) const;
+
+    // Raw state, for drawing and serialisation: counts()[i] is bucket
+    // first_index() + i.
+    uint64_t zero_count() const;
+    int32_t first_index() const;
+    const std::vector<uint64_t>& counts() const;
+    // Midpoint of bucket `index`, within relative_accuracy of its values.
+    double bucket_value(int32_t index) const;
+    // Replaces the contents with saved state; false, leaving the sketch
+    // empty, when the buckets fall outside the config's range.
+    bool restore(uint64_t zero_count, int32_t first_index, std::vector<uint64_t> counts, double sum, double min,
+                 double max);
+
+    size_t memory_bytes() const;
+
+private:
+    int32_t index_of(double value) const;
+    void grow_to(int32_t index);
+
+    HistogramConfig config_;
+    double gamma_;
+    double log_gamma_;
+    int32_t min_index_;
+    int32_t max_index_;
+    int32_t first_index_ = 0;
+    std::vector<uint64_t> counts_;
+    uint64_t zero_count_ = 0;
+    uint64_t count_ = 0;
+    double sum_ = 0.0;
+    double min_ = 0.0;
+    double max_ = 0.0;
+};
+
+// Immutable copy of a tab's scalars and graphs; see Tab::snapshot() and
+// TabReader. Graphs that did not change between two snapshots share one
+// sample vector.
+struct TabSnapshot {
+    struct GraphSamples {
+        // Oldest-first.
+        std::shared_ptr<const std::vector<float>> samples;
+        // Samples the graph had taken in, evicted ones included.
+        uint64_t pushed = 0;
+    };
+
+    std::string id;
+    // 0 for the first snapshot taken without a predecessor, then +1 each.
+    uint64_t version = 0;
+    // Tab::generation() when taken.
+    uint64_t generation = 0;
+    std::map<std::string, ScalarValue, std::less<>> scalars;
+    std::map<std::string, GraphSamples, std::less<>> graphs;
+
+    std::optional<ScalarValue> get_scalar(std::string_view key) const;
+    // Null when the tab had no such graph.
+    std::shared_ptr<const std::vector<float>> get_graph_samples(std::string_view key) const;
 };
 
 class DebugVisualizer {
+    // Monotonic deques of (sequence, value) over a sliding window of
+    // retained samples; amortized O(1) per push and O(1) per query.
+    class SlidingRange {
+    public:
+        void push(uint64_t sequence, float value);
+        void evict_before(uint64_t sequence);
+        void clear();
+        bool empty() const;
+        float min() const;
+        float max() const;
+        size_t memory_bytes() const;
+
+    private:
+        std::deque<std::pair<uint64_t, float>> min_;
+        std::deque<std::pair<uint64_t, float>> max_;
+    };
+
 public:
     class Graph {
     public:
@@ -96,24 +299,215 @@ public:
         GraphConfig& config();
 
         void push(float sample);
+        // Appends a block of samples with at most two copies into the ring;
+        // of a block longer than max_samples only the newest are copied.
+        void add_samples(const float* samples, size_t count);
         void add_samples(const std::vector<float>& samples);
+        // An empty graph adopts the buffer as its ring instead of copying.
+        void add_samples(std::vector<float>&& samples);
 
-        const std::vector<float>& samples() const;
-        std::vector<float>& samples();
+        // Samples oldest-first, copied out of the ring.
+        std::vector<float> samples() const;
+        size_t size() const;
+        bool empty() const;
+        float sample(size_t index) const;
         float latest() const;
+        // Samples taken in so far, evicted ones included.
+        uint64_t pushed() const;
+
+        // Bounds of the retained samples, maintained incrementally (NaNs are
+        // ignored). Both return 0 when there is nothing to bound.
+        float min_sample() const;
+        float max_sample() const;
+
+        // Level-of-detail pyramid, populated when config().level_of_detail is
+        // set. Level L groups 2^L consecutive samples into one (min, max)
+        // bucket; level 0 is the raw ring. Bucket 0 is the oldest bucket that
+        // is still fully retained.
+        size_t lod_levels() const;
+        size_t lod_bucket_count(size_t level) const;
+        std::pair<float, float> lod_bucket(size_t level, size_t index) const;
+
+        // What render() draws across `columns` pixels, oldest first and evenly
+        // spaced: the finest level whose points fit, each bucket of an LOD
+        // level as its min then its max. Raw samples that do not fit are
+        // resampled like ImGui::PlotLines.
+        size_t plot_level(size_t columns) const;
+        void plot_values(size_t columns, std::vector<float>& out) const;
+
+        // Raw ring storage: data()[(i + offset()) % size()] is the i-th oldest
+        // sample, matching ImGui::PlotLines' values_offset convention.
+        const float* data() const;
+        size_t offset() const;
+
+        // Heap bytes held by the ring, the pyramid and the range deques.
+        size_t memory_bytes() const;
 
     private:
         friend class Tab;
+
         void trim_to_config();
+        void rebuild_range();
+        void rebuild_lod();
+        void push_lod(uint64_t sequence, float value);
+        uint64_t lod_first_bucket(size_t level) const;
 
         GraphConfig config_;
-        std::vector<float> samples_;
+        std::vector<float> ring_;
+        size_t start_;
+        uint64_t pushed_;
+        SlidingRange range_;
+        std::vector<std::vector<std::pair<float, float>>> lod_;
         float latest_sample_;
     };
 
+    // Rows of (time, value per series) drawn as one plot on a shared time
+    // axis. Storage is a ring of structure-of-arrays columns: one timestamp
+    // column and one contiguous column per series.
+    class TimeSeries {
+    public:
+        TimeSeries();
+        explicit TimeSeries(TimeSeriesConfig config);
+
+        // Keeps the newest rows that still fit; changing the number of
+        // series drops the history.
+        TimeSeries& configure(const TimeSeriesConfig& config);
+        const TimeSeriesConfig& config() const;
+
+        // Appends a row stamped `time` seconds. Times must not go backwards
+        // (earlier ones are clamped to the newest); missing columns are NaN
+        // and extra ones are dropped. Rows older than time_window behind the
+        // new one are evicted.
+        void push(double time, const float* values, size_t count);
+        void push(double time, std::initializer_list<float> values);
+
+        size_t size() const;
+        bool empty() const;
+        size_t series_count() const;
+        std::string series_label(size_t series) const;
+        // Rows are indexed oldest-first.
+        double time(size_t index) const;
+        float value(size_t series, size_t index) const;
+        double latest_time() const;
+
+        // Bounds over every series, NaNs ignored; 0 when there is nothing
+        // to bound.
+        float min_value() const;
+        float max_value() const;
+
+        size_t memory_bytes() const;
+
+    private:
+        void relayout(size_t columns, size_t capacity);
+        void evict_front(size_t rows);
+        void rebuild_range();
+        size_t slot(size_t index) const;
+
+        TimeSeriesConfig config_;
+        size_t columns_ = 0;
+        size_t capacity_ = 0;
+        // times_[slot]; series c lives at values_[c * capacity_ + slot].
+        std::vector<double> times_;
+        std::vector<float> values_;
+        size_t start_ = 0;
+        size_t size_ = 0;
+        uint64_t pushed_ = 0;
+        SlidingRange range_;
+    };
+
+    // Nested begin/end spans on per-thread lanes, drawn as a flame chart.
+    // Zones are kept while their end lies within `window` seconds of the
+    // newest one, and at most max_zones of them.
+    class ZoneTimeline {
+    public:
+        struct Zone {
+            uint32_t lane = 0;
+            uint32_t name = 0;
+            uint32_t depth = 0;
+            double begin = 0.0;
+            double end = 0.0;
+        };
+
+        explicit ZoneTimeline(double window = 0.5, size_t max_zones = 65536);
+
+        // Interned indices for push(); the same string yields the same index
+        // until clear().
+        uint32_t name_id(const std::string& name);
+        uint32_t lane_id(const std::string& label);
+        const std::string& name(uint32_t id) const;
+        const std::string& lane_label(uint32_t id) const;
+        size_t lane_count() const;
+        // Deepest nesting seen on `lane`, plus one.
+        uint32_t lane_depth(uint32_t lane) const;
+
+        void push(const Zone& zone);
+        void clear();
+
+        // Roughly oldest-first: each lane is in end order, lanes interleave
+        // by arrival.
+        const std::deque<Zone>& zones() const;
+        size_t size() const;
+        bool empty() const;
+        double window() const;
+        double latest_time() const;
+
+        size_t memory_bytes() const;
+
+    private:
+        double window_;
+        size_t max_zones_;
+        std::deque<Zone> zones_;
+        std::vector<std::string> names_;
+        std::map<std::string, uint32_t, std::less<>> name_ids_;
+        std::vector<std::string> lanes_;
+        std::vector<uint32_t> lane_depths_;
+        double latest_ = 0.0;
+    };
+
+    struct ScalarEntry {
+        ScalarValue value;
+        // The "key: value" line as drawn. set() marks it stale only when the
+        // value actually changes, so steady values are never reformatted.
+        mutable std::string text;
+        mutable bool dirty = true;
+
+        void set(ScalarValue next);
+    };
+
+    // Vertices a graph was last drawn with, relative to its plot origin, and
+    // what they were built from. render_graph() replays them for as long as
+    // none of it changes.
+    struct GraphGeometry {
+        struct Vertex {
+            float x;
+            float y;
+            float u;
+            float v;
+            uint32_t color;
+        };
+
+        const Graph* graph = nullptr;
+        uint64_t pushed = 0;
+        size_t size = 0;
+        size_t level = 0;
+        float width = 0.0f;
+        float height = 0.0f;
+        float min_value = 0.0f;
+        float max_value = 0.0f;
+        float white_u = 0.0f;
+        float white_v = 0.0f;
+        uint32_t color = 0;
+        int flags = 0;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
     struct StructureEntry {
-        StructureNode root;
-        bool has_content = false;
+        StructureTree tree;
+        // Latest builder published while the tab was hidden.
+        std::function<void(StructureBuilder&)> deferred;
+        // Set when showing the tab ran `deferred`; see take_shown_structures().
+        bool shown = false;
     };
 
     class Tab {
@@ -155,12 +549,61 @@ public:
 
         Tab& push_graph_sample(const std::string& key, float sample, const GraphConfig& config = {});
         Tab& add_graph_samples(const std::string& key, const std::vector<float>& samples, const GraphConfig& config = {});
+        Tab& add_graph_samples(const std::string& key, std::vector<float>&& samples, const GraphConfig& config = {});
+        Tab& add_graph_samples(const std::string& key,
+                               const float* samples,
+                               size_t count,
+                               const GraphConfig& config = {});
+
+        Tab& configure_series(const std::string& key, const TimeSeriesConfig& config);
+        Tab& push_series_sample(const std::string& key, double time, const float* values, size_t count);
+        Tab& push_series_sample(const std::string& key, double time, std::initializer_list<float> values);
+
+        // Merges into the sketch for `key`; one with a different config
+        // replaces it.
+        Tab& merge_histogram(const std::string& key, const QuantileSketch& sketch);
+        Tab& add_histogram_sample(const std::string& key, double value, const HistogramConfig& config = {});
+
+        // Created on first use; see ZoneTimeline.
+        ZoneTimeline& zone_timeline(const std::string& key);
 
         Tab& update_structure(const std::string& key, const std::function<void(StructureBuilder&)>& builder);
+        // Like update_structure(), but while the tab is hidden only the latest
+        // builder is kept and it runs when the tab is next shown, so the
+        // builder must own everything it captures.
+        Tab& defer_structure(const std::string& key, std::function<void(StructureBuilder&)> builder);
+
+        // False once a render found the tab hidden while its visualizer defers
+        // hidden structures; true otherwise.
+        bool is_shown() const;
+        // Keys whose deferred builder ran since the last call, so their new
+        // trees can be forwarded once.
+        std::vector<std::string> take_shown_structures();
 
         std::optional<ScalarValue> get_scalar(const std::string& key) const;
         std::vector<float> get_graph_samples(const std::string& key) const;
+        // The last built tree; a builder still deferred is not run.
         std::optional<StructureNode> get_structure(const std::string& key) const;
+        const DebugVisualizer::Graph* find_graph(const std::string& key) const;
+        const TimeSeries* find_series(const std::string& key) const;
+        const ZoneTimeline* find_zone_timeline(const std::string& key) const;
+        const QuantileSketch* find_histogram(const std::string& key) const;
+
+        std::vector<std::string> scalar_keys() const;
+        std::vector<std::string> graph_keys() const;
+        std::vector<std::string> series_keys() const;
+        std::vector<std::string> zone_timeline_keys() const;
+        std::vector<std::string> histogram_keys() const;
+        std::vector<std::string> structure_keys() const;
+
+        // Storage for `key`, created on first use. The reference stays valid
+        // until clear(), which bumps generation().
+        ScalarEntry& scalar_slot(const std::string& key);
+        uint64_t generation() const;
+
+        // Copies the scalars and graphs out. Graphs with the same sample
+        // count and push count as in `previous` reuse its sample vector.
+        std::shared_ptr<const TabSnapshot> snapshot(const TabSnapshot* previous = nullptr) const;
 
         void clear();
 
@@ -168,12 +611,33 @@ public:
         friend class DebugVisualizer;
         friend class GraphCollection;
     DebugVisualizer::Graph& ensure_graph(const std::string& key, const GraphConfig& config = {});
+        void refresh_rows() const;
+        void set_shown(bool shown);
 
         std::string id_;
         std::string title_;
-        std::map<std::string, ScalarValue> scalars_;
+        std::map<std::string, ScalarEntry> scalars_;
         std::map<std::string, DebugVisualizer::Graph> graphs_;
+        std::map<std::string, TimeSeries> series_;
+        std::map<std::string, ZoneTimeline> timelines_;
+        std::map<std::string, QuantileSketch> histograms_;
         std::map<std::string, StructureEntry> structures_;
+        uint64_t generation_ = 0;
+        bool shown_ = true;
+        size_t deferred_count_ = 0;
+        size_t shown_count_ = 0;
+
+        // Random-access views of scalars_, graphs_, series_ and histograms_
+        // for clipped rendering.
+        // Keys are only ever added between clears, so a size or generation
+        // change is enough to tell them apart from the maps.
+        mutable std::vector<const std::pair<const std::string, ScalarEntry>*> scalar_rows_;
+        mutable std::vector<const std::pair<const std::string, DebugVisualizer::Graph>*> graph_rows_;
+        mutable std::vector<const std::pair<const std::string, TimeSeries>*> series_rows_;
+        mutable std::vector<const std::pair<const std::string, QuantileSketch>*> histogram_rows_;
+        // Parallel to graph_rows_.
+        mutable std::vector<GraphGeometry> graph_geometry_;
+        mutable uint64_t rows_generation_ = 0;
     };
 
     class TabCollection {
@@ -202,6 +666,12 @@ public:
     void set_visible(bool visible);
     bool is_visible() const;
 
+    // Hold back Tab::defer_structure() builders for tabs that are not on
+    // screen (inactive tab, or hidden window) until they are shown again.
+    // Applies to this visualizer and its window tiles.
+    void set_defer_hidden_structures(bool defer);
+    bool defer_hidden_structures() const;
+
     Tab& add_tab(const std::string& id);
     Tab& add_tab(const std::string& id, const std::string& title);
     Tab* find_tab(const std::string& id);
@@ -230,10 +700,15 @@ public:
 
     void push_graph_sample(const std::string& key, float sample, const GraphConfig& config = {});
     void add_graph_samples(const std::string& key, const std::vector<float>& samples, const GraphConfig& config = {});
+    void add_graph_samples(const std::string& key, std::vector<float>&& samples, const GraphConfig& config = {});
+    void add_graph_samples(const std::string& key, const float* samples, size_t count, const GraphConfig& config = {});
 
     void update_structure(const std::string& key, const std::function<void(StructureBuilder&)>& builder);
 
     void render();
+    // Stands in for render() on frames that are not drawn: tabs count as
+    // shown while their window is visible.
+    void skip_render();
 
     std::optional<ScalarValue> get_scalar(const std::string& key) const;
     std::vector<float> get_graph_samples(const std::string& key) const;
@@ -243,22 +718,42 @@ private:
     friend class TabCollection;
     Tab& ensure_tab(const std::string& id, const std::string& title);
     const Tab* find_tab_internal(const std::string& id) const;
+    void set_tabs_shown(bool shown);
 
     std::string window_title_;
     int window_flags_;
     bool visible_;
+    bool defer_hidden_structures_;
     std::string default_tab_id_;
+    // Both lists keep insertion order, which is the display order; the
+    // indexes find an entry by id without walking them.
     std::vector<std::unique_ptr<Tab>> tabs_;
+    std::unordered_map<std::string, Tab*> tab_index_;
     struct WindowTile {
         std::string id;
         std::unique_ptr<DebugVisualizer> visualizer;
     };
     std::vector<WindowTile> window_tiles_;
+    std::unordered_map<std::string, DebugVisualizer*> window_tile_index_;
 
     void render_tab_contents(const Tab& tab) const;
-    void render_scalar(const std::string& key, const ScalarValue& value) const;
-    void render_graph(const std::string& key, const DebugVisualizer::Graph& graph) const;
-    void render_structure_node(const StructureNode& node) const;
+    void render_scalar(const std::string& key, const ScalarEntry& entry) const;
+    void render_graph(const std::string& key, const DebugVisualizer::Graph& graph, GraphGeometry& geometry) const;
+    void render_series(const std::string& key, const TimeSeries& series) const;
+    void render_histogram(const std::string& key, const QuantileSketch& sketch) const;
+    void render_zone_timeline(const std::string& key, const ZoneTimeline& timeline) const;
+    void render_structure_node(const StructureTree& tree, uint32_t index) const;
+};
+
+enum class ProducerQueueMode {
+    kShared,
+    kPerThreadRing,
+};
+
+enum class QueueOverflowPolicy {
+    kDropOldest,
+    kDropNewest,
+    kBlock,
 };
 
 struct DebugVisualizerAppOptions {
@@ -271,6 +766,116 @@ struct DebugVisualizerAppOptions {
     bool enable_keyboard_navigation = true;
     bool enable_docking = false;
     bool vsync = true;
+    // Draw only when something changed: the loop sleeps until input arrives
+    // or request_redraw() is called (the background service does so when
+    // updates are pending), never above max_fps, and redraws at least at
+    // min_refresh_hz (0 = never) so continuously moving graphs stay live.
+    // The update callback only runs for frames that are drawn.
+    bool render_on_change = false;
+    float max_fps = 60.0f;
+    float min_refresh_hz = 1.0f;
+    // Structures published through dbgvis::structure() to a tab or tile that
+    // is not on screen only keep their latest builder, which runs when the
+    // tab is shown again. Scalars stay last-value and graphs keep appending.
+    bool defer_hidden_structures = false;
+    // Background service only: append every typed update to this file (see
+    // debug_visualizer/recording.h), with a full keyframe of the tile every
+    // record_keyframe_interval recorded frames.
+    std::string record_path;
+    size_t record_keyframe_interval = 300;
+    // Play back a recording instead of live data, with seek/play controls.
+    std::string replay_path;
+    // Background service only: also send every typed update to a viewer
+    // listening at "unix:/path" or "tcp:host:port". Publishing never waits
+    // for the viewer; frames it cannot take are dropped and it catches up
+    // from a keyframe. stream_name (default "<host>/<program>[<pid>]") is
+    // the window tile the viewer shows this process in.
+    // "shm:" instead publishes through a shared-memory ring of
+    // shm_ring_capacity bytes that a viewer on the same host drains without
+    // any syscall on this side.
+    std::string stream_address;
+    std::string stream_name;
+    size_t shm_ring_capacity = 16u << 20;
+    // Accept streams at this address and show each producer as its own
+    // window tile (see debug_visualizer_viewer); "shm:" or "shm:<prefix>"
+    // watches same-host shared-memory producers instead. Both are read once
+    // per frame, so with render_on_change new data shows at min_refresh_hz.
+    std::string listen_address;
+    // Run the data model on a timer without a window or GL context; only
+    // the data-model target needs to be linked.
+    bool headless = false;
+    float headless_update_hz = 30.0f;
+    // Start headless and open the window only once attach_window() (or, for
+    // the background service, ShowBackgroundVisualizerWindow()) is called;
+    // the tabs built up so far carry over. Processes that never ask for the
+    // window never initialize GLFW, GL or ImGui. Ignored with `headless`.
+    bool defer_window = false;
+    ProducerQueueMode producer_queue = ProducerQueueMode::kShared;
+    size_t producer_ring_capacity = 4096;
+    // Last write wins for scalar and structure updates between two flushes;
+    // graph samples are still appended in order.
+    bool coalesce_updates = false;
+    // Bound on pending updates (0 = unbounded): the shared queue in kShared
+    // mode, each thread's overflow list in kPerThreadRing mode. Updates lost
+    // to the policy are counted by DroppedUpdateCount(). clear_tab(),
+    // set_window_title() and show_window() are never dropped and do not count
+    // against the bound, so kDropOldest drops the oldest other update. kBlock
+    // does not apply to publishes from the service thread itself (structure
+    // builders, for instance), which could never be drained; they skip the
+    // bound.
+    size_t update_queue_capacity = 0;
+    QueueOverflowPolicy queue_overflow_policy = QueueOverflowPolicy::kDropOldest;
+    // Background service only: large flushes are split by tab and applied on
+    // this many worker threads besides the render thread (0 = render thread
+    // only). Each tab still sees its updates in order; clear_tab(),
+    // structures and zones are applied alone, in queue order.
+    size_t flush_threads = 0;
+    // Adds a "dbgvis internals" window tile showing GetVisualizerStats().
+    // It is drawn locally only: recordings and streams do not carry it.
+    bool show_internals = false;
+};
+
+// Wall time of the stages of the latest frame drawn by run(), in
+// milliseconds. present_ms includes any vsync wait in the buffer swap.
+struct AppFrameStats {
+    uint64_t frames = 0;
+    double callback_ms = 0.0;
+    double render_ms = 0.0;
+    double imgui_render_ms = 0.0;
+    double present_ms = 0.0;
+};
+
+struct TabStats {
+    std::string id;
+    size_t scalars = 0;
+    size_t graphs = 0;
+    size_t series = 0;
+    size_t histograms = 0;
+    size_t structures = 0;
+    // memory_bytes() of every Graph, TimeSeries and histogram by key.
+    std::vector<std::pair<std::string, size_t>> graph_bytes;
+};
+
+// The background visualizer's own cost, as of its latest frame.
+struct VisualizerStats {
+    bool running = false;
+    uint64_t frames = 0;
+    // Records drained by the latest flush, and the most seen in one flush.
+    size_t queue_depth = 0;
+    size_t peak_queue_depth = 0;
+    // Record storage reserved by the shared queue, the flush buffer and the
+    // producer rings; payloads the records point to are not included.
+    size_t queue_bytes = 0;
+    uint64_t updates_applied = 0;
+    // Averaged over about the last second.
+    double updates_per_second = 0.0;
+    uint64_t dropped_updates = 0;
+    double flush_ms = 0.0;
+    double render_ms = 0.0;
+    double imgui_render_ms = 0.0;
+    double present_ms = 0.0;
+    // Tabs of the main tile, refreshed twice a second.
+    std::vector<TabStats> tabs;
 };
 
 class DebugVisualizerApp {
@@ -313,7 +918,15 @@ public:
     const DebugVisualizer* findTile(const std::string& id) const;
 
     void request_close();
+    // Schedules a frame in render_on_change mode; safe to call from any thread.
+    void request_redraw();
+    // Opens the window of an app started with options.defer_window, at the
+    // start of the next frame; safe to call from any thread. If the window
+    // cannot be created the app keeps running headless.
+    void attach_window();
     bool is_running() const;
+    // Timings of the previous frame; read it from the update callback.
+    const AppFrameStats& frame_stats() const;
 
 private:
     friend class TileCollection;
@@ -327,11 +940,145 @@ private:
 int RunVisualizerApp(bool enable_docking, const DebugVisualizerApp::UpdateCallback& callback);
 int RunVisualizerApp(DebugVisualizerAppOptions options, const DebugVisualizerApp::UpdateCallback& callback);
 
+struct TabHandle {
+    uint32_t id = UINT32_MAX;
+
+    bool valid() const {
+        return id != UINT32_MAX;
+    }
+};
+
+struct Key {
+    uint32_t id = UINT32_MAX;
+
+    bool valid() const {
+        return id != UINT32_MAX;
+    }
+};
+
+#if DBGVIS_ENABLED
+
 void StartBackgroundVisualizer();
 void StartBackgroundVisualizer(bool enable_docking);
 void StartBackgroundVisualizer(DebugVisualizerAppOptions options);
 void ShutdownBackgroundVisualizer();
+// True from StartBackgroundVisualizer() (or the first publish) until the
+// service stops; updates are accepted from the first call either way.
 bool IsBackgroundVisualizerRunning();
+// Attaches the window of a service started with options.defer_window, at
+// its next tick. Only stores a flag, so it is safe from a signal handler
+// (e.g. on SIGUSR1) or the host's own hotkey handling.
+void ShowBackgroundVisualizerWindow();
+uint64_t DroppedUpdateCount();
+// Snapshot of the service's own counters and timings; safe from any thread.
+VisualizerStats GetVisualizerStats();
+
+// Resolve a tab/key pair once and publish through the returned handle; handle
+// publishing skips all string hashing, comparison and copying.
+TabHandle register_tab(const std::string& tab_id);
+Key register_value(const std::string& tab_id, const std::string& key);
+Key register_value(TabHandle tab, const std::string& key);
+Key register_graph(const std::string& tab_id, const std::string& key, const GraphConfig& config = {});
+Key register_graph(TabHandle tab, const std::string& key, const GraphConfig& config = {});
+
+void value(Key key, int value);
+void value(Key key, int64_t value);
+void value(Key key, float value);
+void value(Key key, double value);
+void value(Key key, bool value);
+void value(Key key, std::string value);
+void value(Key key, const char* value);
+
+void graph_sample(Key key, float sample);
+
+// Counters and gauges skip the update queue: producers write an atomic and
+// the service thread reads it once per frame, publishing the scalar only
+// when it changed. Copies share the same value; the key keeps showing its
+// last value after every copy is gone. Constructing one starts the service
+// like any other publish.
+class Counter {
+public:
+    struct alignas(64) Shard {
+        std::atomic<int64_t> value{0};
+    };
+    static constexpr size_t kShards = 16;
+
+    Counter() = default;
+    Counter(const std::string& tab_id, const std::string& key);
+
+    // One relaxed atomic add on the calling thread's shard.
+    void add(int64_t delta = 1) {
+        if (shards_) {
+            shards_[ThreadShard()].value.fetch_add(delta, std::memory_order_relaxed);
+        }
+    }
+    // Sum over the shards; concurrent adds may or may not be included.
+    int64_t value() const;
+    bool valid() const {
+        return shards_ != nullptr;
+    }
+
+private:
+    static size_t ThreadShard() {
+        thread_local const size_t shard = next_shard_.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return shard;
+    }
+
+    static inline std::atomic<size_t> next_shard_{0};
+    std::shared_ptr<Shard[]> shards_;
+};
+
+// Last write wins. NaN reads as "not set yet" and is not shown.
+class Gauge {
+public:
+    struct alignas(64) Cell {
+        std::atomic<double> value{std::numeric_limits<double>::quiet_NaN()};
+    };
+
+    Gauge() = default;
+    Gauge(const std::string& tab_id, const std::string& key);
+
+    void set(double value) {
+        if (cell_) {
+            cell_->value.store(value, std::memory_order_relaxed);
+        }
+    }
+    double value() const {
+        return cell_ ? cell_->value.load(std::memory_order_relaxed) : std::numeric_limits<double>::quiet_NaN();
+    }
+    bool valid() const {
+        return cell_ != nullptr;
+    }
+
+private:
+    std::shared_ptr<Cell> cell_;
+};
+
+// Reads a tab of the background visualizer from any thread. After each
+// flush that changed the tab, the service publishes a new immutable
+// TabSnapshot; get() hands out the latest one without waiting for the
+// service. Only tabs with a live reader are snapshotted.
+class TabReader {
+public:
+    struct Slot {
+        std::shared_ptr<const TabSnapshot> latest;
+    };
+
+    TabReader() = default;
+    explicit TabReader(const std::string& tab_id);
+
+    // Null until the first flush after construction, and while the tab
+    // does not exist. Versions restart at 0 when the service restarts.
+    std::shared_ptr<const TabSnapshot> get() const {
+        return slot_ ? std::atomic_load(&slot_->latest) : nullptr;
+    }
+    bool valid() const {
+        return slot_ != nullptr;
+    }
+
+private:
+    std::shared_ptr<Slot> slot_;
+};
 
 void value(const std::string& tab_id, const std::string& key, int value);
 void value(const std::string& tab_id, const std::string& key, int64_t value);
@@ -371,6 +1118,15 @@ inline void value(const std::string& key, const char* v) {
 
 void graph_sample(const std::string& tab_id, const std::string& key, float sample, const GraphConfig& config = {});
 void graph_samples(const std::string& tab_id, const std::string& key, const std::vector<float>& samples, const GraphConfig& config = {});
+// The block is copied once into the queued update; the vector overload
+// below hands the buffer over instead, and it becomes the graph's ring when
+// the graph is empty.
+void graph_samples(const std::string& tab_id,
+                   const std::string& key,
+                   const float* samples,
+                   size_t count,
+                   const GraphConfig& config = {});
+void graph_samples(const std::string& tab_id, const std::string& key, std::vector<float>&& samples, const GraphConfig& config = {});
 
 inline void graph_sample(const std::string& key, float sample, const GraphConfig& config = {}) {
     graph_sample("Telemetry", key, sample, config);
@@ -380,10 +1136,70 @@ inline void graph_samples(const std::string& key, const std::vector<float>& samp
     graph_samples("Telemetry", key, samples, config);
 }
 
-void structure(const std::string& tab_id, const std::string& key, const std::function<void(StructureBuilder&)>& builder);
+inline void graph_samples(const std::string& key, const float* samples, size_t count, const GraphConfig& config = {}) {
+    graph_samples("Telemetry", key, samples, count, config);
+}
 
-inline void structure(const std::string& key, const std::function<void(StructureBuilder&)>& builder) {
-    structure("Telemetry", key, builder);
+inline void graph_samples(const std::string& key, std::vector<float>&& samples, const GraphConfig& config = {}) {
+    graph_samples("Telemetry", key, std::move(samples), config);
+}
+
+// Multi-series plots on a shared time axis. Each row is stamped when
+// series_sample() is called; a series that was never configured takes the
+// default config and one column per value of its first row.
+void configure_series(const std::string& tab_id, const std::string& key, const TimeSeriesConfig& config);
+void series_sample(const std::string& tab_id, const std::string& key, const float* values, size_t count);
+void series_sample(const std::string& tab_id, const std::string& key, std::initializer_list<float> values);
+
+inline void series_sample(const std::string& key, std::initializer_list<float> values) {
+    series_sample("Telemetry", key, values);
+}
+
+// Records `value` into the distribution shown for `key`. Values collect in
+// a per-thread sketch that is posted about every 50 ms, also after the
+// thread stops recording, so recording costs a bucket increment rather than
+// a queued update.
+void histogram(const std::string& tab_id, const std::string& key, double value, const HistogramConfig& config = {});
+
+inline void histogram(const std::string& key, double value, const HistogramConfig& config = {}) {
+    histogram("Telemetry", key, value, config);
+}
+
+// Posts the calling thread's pending histogram values now rather than
+// within the next 50 ms.
+void flush_histograms();
+
+// Zone profiling: DBGVIS_SCOPE("Render/Cull") times the rest of the
+// enclosing block. Zones are buffered per thread and posted in batches, at
+// the latest about 10 ms after they end even if the thread goes quiet; the
+// service draws them on a timeline in the "Profiler" tab and graphs each
+// zone's mean and p99 duration there.
+struct ZoneSite {
+    explicit ZoneSite(const char* name);
+
+    uint32_t id;
+};
+
+class ScopedZone {
+public:
+    explicit ScopedZone(const ZoneSite& site);
+    ~ScopedZone();
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+    uint32_t site_;
+    int64_t begin_ns_;
+};
+
+// Posts the calling thread's buffered zones now rather than at the next
+// batch boundary.
+void flush_zones();
+
+void structure(const std::string& tab_id, const std::string& key, std::function<void(StructureBuilder&)> builder);
+
+inline void structure(const std::string& key, std::function<void(StructureBuilder&)> builder) {
+    structure("Telemetry", key, std::move(builder));
 }
 
 void clear_tab(const std::string& tab_id);
@@ -395,4 +1211,178 @@ inline void clear_tab() {
 void set_window_title(std::string title);
 void show_window(bool visible);
 
+#define DBGVIS_VALUE(...) ::dbgvis::value(__VA_ARGS__)
+#define DBGVIS_GRAPH_SAMPLE(...) ::dbgvis::graph_sample(__VA_ARGS__)
+#define DBGVIS_GRAPH_SAMPLES(...) ::dbgvis::graph_samples(__VA_ARGS__)
+#define DBGVIS_SERIES_SAMPLE(...) ::dbgvis::series_sample(__VA_ARGS__)
+#define DBGVIS_HISTOGRAM(...) ::dbgvis::histogram(__VA_ARGS__)
+#define DBGVIS_STRUCTURE(...) ::dbgvis::structure(__VA_ARGS__)
+
+#define DBGVIS_CONCAT_INNER(a, b) a##b
+#define DBGVIS_CONCAT(a, b) DBGVIS_CONCAT_INNER(a, b)
+// __COUNTER__ rather than __LINE__, so two scopes on one line (or from one
+// macro expansion) get distinct names.
+#define DBGVIS_SCOPE_WITH_ID(name, id)                                             \
+    static const ::dbgvis::ZoneSite DBGVIS_CONCAT(dbgvis_zone_site_, id){name}; \
+    const ::dbgvis::ScopedZone DBGVIS_CONCAT(dbgvis_zone_, id) {                 \
+        DBGVIS_CONCAT(dbgvis_zone_site_, id)                                     \
+    }
+#define DBGVIS_SCOPE(name) DBGVIS_SCOPE_WITH_ID(name, __COUNTER__)
+
+#else  // !DBGVIS_ENABLED
+
+// Compiled-out API: every publishing call keeps its enabled signature, so
+// the same call sites (braced arguments included) compile either way. Names
+// are taken as std::string_view and structure builders as a template, so
+// call sites build no std::string or std::function temporaries; the
+// DBGVIS_* macros additionally skip evaluating the arguments at all.
+inline void StartBackgroundVisualizer() {}
+inline void StartBackgroundVisualizer(bool) {}
+inline void StartBackgroundVisualizer(const DebugVisualizerAppOptions&) {}
+inline void ShutdownBackgroundVisualizer() {}
+constexpr bool IsBackgroundVisualizerRunning() {
+    return false;
+}
+inline void ShowBackgroundVisualizerWindow() {}
+constexpr uint64_t DroppedUpdateCount() {
+    return 0;
+}
+inline VisualizerStats GetVisualizerStats() {
+    return {};
+}
+
+inline TabHandle register_tab(std::string_view) {
+    return TabHandle{};
+}
+inline Key register_value(std::string_view, std::string_view) {
+    return Key{};
+}
+inline Key register_value(TabHandle, std::string_view) {
+    return Key{};
+}
+inline Key register_graph(std::string_view, std::string_view, const GraphConfig& = {}) {
+    return Key{};
+}
+inline Key register_graph(TabHandle, std::string_view, const GraphConfig& = {}) {
+    return Key{};
+}
+
+inline void value(Key, int) {}
+inline void value(Key, int64_t) {}
+inline void value(Key, float) {}
+inline void value(Key, double) {}
+inline void value(Key, bool) {}
+inline void value(Key, std::string_view) {}
+inline void value(Key, const char*) {}
+inline void graph_sample(Key, float) {}
+
+class Counter {
+public:
+    Counter() = default;
+    Counter(std::string_view, std::string_view) {}
+
+    void add(int64_t = 1) {}
+    int64_t value() const {
+        return 0;
+    }
+    bool valid() const {
+        return false;
+    }
+};
+
+class Gauge {
+public:
+    Gauge() = default;
+    Gauge(std::string_view, std::string_view) {}
+
+    void set(double) {}
+    double value() const {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    bool valid() const {
+        return false;
+    }
+};
+
+class TabReader {
+public:
+    TabReader() = default;
+    explicit TabReader(std::string_view) {}
+
+    std::shared_ptr<const TabSnapshot> get() const {
+        return nullptr;
+    }
+    bool valid() const {
+        return false;
+    }
+};
+
+inline void value(std::string_view, std::string_view, int) {}
+inline void value(std::string_view, std::string_view, int64_t) {}
+inline void value(std::string_view, std::string_view, float) {}
+inline void value(std::string_view, std::string_view, double) {}
+inline void value(std::string_view, std::string_view, bool) {}
+inline void value(std::string_view, std::string_view, std::string_view) {}
+inline void value(std::string_view, std::string_view, const char*) {}
+inline void value(std::string_view, int) {}
+inline void value(std::string_view, int64_t) {}
+inline void value(std::string_view, float) {}
+inline void value(std::string_view, double) {}
+inline void value(std::string_view, bool) {}
+inline void value(std::string_view, std::string_view) {}
+inline void value(std::string_view, const char*) {}
+
+inline void graph_sample(std::string_view, std::string_view, float, const GraphConfig& = {}) {}
+inline void graph_samples(std::string_view, std::string_view, const std::vector<float>&, const GraphConfig& = {}) {}
+inline void graph_samples(std::string_view, std::string_view, const float*, size_t, const GraphConfig& = {}) {}
+inline void graph_sample(std::string_view, float, const GraphConfig& = {}) {}
+inline void graph_samples(std::string_view, const std::vector<float>&, const GraphConfig& = {}) {}
+inline void graph_samples(std::string_view, const float*, size_t, const GraphConfig& = {}) {}
+
+inline void configure_series(std::string_view, std::string_view, const TimeSeriesConfig&) {}
+inline void series_sample(std::string_view, std::string_view, const float*, size_t) {}
+inline void series_sample(std::string_view, std::string_view, std::initializer_list<float>) {}
+inline void series_sample(std::string_view, std::initializer_list<float>) {}
+
+inline void histogram(std::string_view, std::string_view, double, const HistogramConfig& = {}) {}
+inline void histogram(std::string_view, double, const HistogramConfig& = {}) {}
+inline void flush_histograms() {}
+
+// The std::function overloads take braced and null builders.
+template <class Builder>
+void structure(std::string_view, std::string_view, Builder&&) {}
+template <class Builder>
+void structure(std::string_view, Builder&&) {}
+inline void structure(std::string_view, std::string_view, std::function<void(StructureBuilder&)>) {}
+inline void structure(std::string_view, std::function<void(StructureBuilder&)>) {}
+inline void clear_tab(std::string_view) {}
+inline void clear_tab() {}
+inline void set_window_title(std::string_view) {}
+inline void show_window(bool) {}
+inline void flush_zones() {}
+
+#define DBGVIS_VALUE(...) \
+    do {                  \
+    } while (false)
+#define DBGVIS_GRAPH_SAMPLE(...) \
+    do {                         \
+    } while (false)
+#define DBGVIS_GRAPH_SAMPLES(...) \
+    do {                          \
+    } while (false)
+#define DBGVIS_SERIES_SAMPLE(...) \
+    do {                          \
+    } while (false)
+#define DBGVIS_HISTOGRAM(...) \
+    do {                      \
+    } while (false)
+#define DBGVIS_STRUCTURE(...) \
+    do {                      \
+    } while (false)
+#define DBGVIS_SCOPE(name) \
+    do {                   \
+    } while (false)
+
+#endif  // DBGVIS_ENABLED
+
 }  // namespace dbgvis
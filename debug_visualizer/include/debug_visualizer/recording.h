@@ -0,0 +1,67 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+namespace dbgvis {
+
+// Read side of a recording written by the background service (see
+// DebugVisualizerAppOptions::record_path). The file is memory-mapped; seek()
+// binary-searches the keyframe index for the closest snapshot at or before
+// the target frame and replays only the updates after it. Stepping forward
+// from the current frame continues where the last seek() stopped.
+class RecordingReader {
+public:
+    // Null when the file cannot be mapped or is not a recording.
+    static std::unique_ptr<RecordingReader> open(const std::string& path);
+
+    ~RecordingReader();
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    // The DebugVisualizerApp tile the recording was captured from.
+    const std::string& tile_id() const;
+    uint64_t frame_count() const;
+    uint64_t keyframe_count() const;
+    // Seconds from the first to the last recorded frame.
+    double duration() const;
+
+    // Rebuilds `tile` as it was after `frame`. On success, frame() and time()
+    // describe that frame.
+    bool seek(uint64_t frame, DebugVisualizer& tile);
+    uint64_t frame() const;
+    double time() const;
+
+private:
+    struct Impl;
+
+    RecordingReader();
+
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace dbgvis
@@ -0,0 +1,74 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+struct ImDrawData;
+
+namespace dbgvis {
+
+// Platform layer driven by DebugVisualizerApp::run(). The windowed backend
+// owns the native window, the GL context and the ImGui platform/renderer
+// bindings; the headless backend only paces the loop so the data model keeps
+// flushing without a display.
+class AppBackend {
+public:
+    virtual ~AppBackend() = default;
+
+    virtual bool Initialize(const DebugVisualizerAppOptions& options) = 0;
+    virtual void Shutdown() = 0;
+
+    // False for the headless backend: no ImGui frame is built at all.
+    virtual bool Renders() const = 0;
+
+    virtual bool ShouldClose() const = 0;
+    virtual void RequestClose() = 0;
+
+    // Processes pending input; the headless backend sleeps until the next tick.
+    virtual void PollEvents() = 0;
+    // Blocks until input arrives, Wake() is called or `timeout` seconds pass.
+    virtual void WaitEvents(double timeout) = 0;
+    // Interrupts WaitEvents(); safe to call from any thread.
+    virtual void Wake() = 0;
+    virtual double Time() const = 0;
+
+    virtual void NewFrame() = 0;
+    virtual void Present(ImDrawData* draw_data) = 0;
+
+    virtual void SetTitle(const std::string& title) = 0;
+};
+
+using AppBackendFactory = std::unique_ptr<AppBackend> (*)();
+
+std::unique_ptr<AppBackend> CreateHeadlessBackend();
+
+// The windowed backend lives in its own target so the data model can be
+// linked without GLFW/GLEW/X11. It registers itself during static
+// initialization; CreateWindowedBackend() returns null when it is not linked.
+bool RegisterWindowedBackend(AppBackendFactory factory);
+std::unique_ptr<AppBackend> CreateWindowedBackend();
+
+}  // namespace dbgvis
@@ -22,6 +22,11 @@
 #include "debug_visualizer/debug_visualizer.h"
 
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <utility>
@@ -38,6 +43,25 @@ struct Overload : Ts... {
 template <class... Ts>
 Overload(Ts...) -> Overload<Ts...>;
 
+// Coarsest pyramid level still has at least this many buckets.
+constexpr size_t kMinLodBuckets = 64;
+constexpr float kGraphHeight = 80.0f;
+constexpr float kLegendSpacing = 8.0f;
+constexpr ImU32 kSeriesColors[] = {
+    IM_COL32(86, 180, 233, 255),
+    IM_COL32(230, 159, 0, 255),
+    IM_COL32(0, 158, 115, 255),
+    IM_COL32(240, 228, 66, 255),
+    IM_COL32(204, 121, 167, 255),
+    IM_COL32(213, 94, 0, 255),
+    IM_COL32(0, 114, 178, 255),
+    IM_COL32(200, 200, 200, 255),
+};
+
+float HistogramBarGetter(void* data, int index) {
+    return static_cast<float>(static_cast<const QuantileSketch*>(data)->counts()[static_cast<size_t>(index)]);
+}
+
 std::string ScalarToString(const ScalarValue& value) {
     return std::visit(
         Overload{
@@ -61,54 +85,368 @@ std::string ScalarToString(const ScalarValue& value) {
 }
 }  // namespace
 
-StructureBuilder::StructureBuilder(std::vector<StructureNode>* nodes) : nodes_(nodes) {}
+StructureTree::StructureTree() : nodes_(1) {
+    nodes_[0].branch = true;
+}
 
-void StructureBuilder::field(const std::string& label, int value) {
-    field(label, static_cast<int64_t>(value));
+void StructureTree::update(const std::function<void(StructureBuilder&)>& builder) {
+    ++stamp_;
+    nodes_[0].stamp = stamp_;
+    StructureBuilder root(this, 0);
+    if (builder) {
+        builder(root);
+    }
+    sweep();
 }
 
-void StructureBuilder::field(const std::string& label, int64_t value) {
-    if (!nodes_) {
-        return;
+void StructureTree::clear() {
+    nodes_.resize(1);
+    nodes_[0].first_child = kNone;
+    free_ = kNone;
+    live_ = 0;
+}
+
+const StructureTree::Node& StructureTree::node(uint32_t index) const {
+    return nodes_[index];
+}
+
+const StructureTree::Node& StructureTree::root() const {
+    return nodes_[0];
+}
+
+bool StructureTree::empty() const {
+    return nodes_[0].first_child == kNone;
+}
+
+size_t StructureTree::size() const {
+    return live_;
+}
+
+StructureNode StructureTree::snapshot() const {
+    return snapshot_node(0);
+}
+
+StructureNode StructureTree::snapshot_node(uint32_t index) const {
+    const Node& source = nodes_[index];
+    StructureNode result{source.label, source.value, {}};
+    for (uint32_t child = source.first_child; child != kNone; child = nodes_[child].next_sibling) {
+        result.children.push_back(snapshot_node(child));
     }
-    nodes_->push_back(StructureNode{label, ScalarValue{value}, {}});
+    return result;
 }
 
-void StructureBuilder::field(const std::string& label, float value) {
-    field(label, static_cast<double>(value));
+uint32_t StructureTree::allocate() {
+    ++live_;
+    if (free_ != kNone) {
+        const uint32_t index = free_;
+        free_ = nodes_[index].next_sibling;
+        return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void StructureTree::release(uint32_t index) {
+    released_.push_back(index);
+    while (!released_.empty()) {
+        const uint32_t current = released_.back();
+        released_.pop_back();
+        Node& node = nodes_[current];
+        for (uint32_t child = node.first_child; child != kNone; child = nodes_[child].next_sibling) {
+            released_.push_back(child);
+        }
+        // Keep the label's and text's capacity for the next node in this slot.
+        node.value.reset();
+        node.first_child = kNone;
+        node.next_sibling = free_;
+        free_ = current;
+        --live_;
+    }
 }
 
-void StructureBuilder::field(const std::string& label, double value) {
-    if (!nodes_) {
-        return;
+void StructureTree::sweep() {
+    pending_.push_back(0);
+    while (!pending_.empty()) {
+        const uint32_t parent = pending_.back();
+        pending_.pop_back();
+
+        uint32_t prev = kNone;
+        uint32_t child = nodes_[parent].first_child;
+        while (child != kNone) {
+            const uint32_t next = nodes_[child].next_sibling;
+            if (nodes_[child].stamp == stamp_) {
+                if (nodes_[child].branch) {
+                    pending_.push_back(child);
+                }
+                prev = child;
+            } else {
+                if (prev == kNone) {
+                    nodes_[parent].first_child = next;
+                } else {
+                    nodes_[prev].next_sibling = next;
+                }
+                release(child);
+            }
+            child = next;
+        }
+    }
+}
+
+StructureBuilder::StructureBuilder(StructureTree* tree, uint32_t parent)
+    : tree_(tree),
+      parent_(parent),
+      prev_(StructureTree::kNone),
+      cursor_(tree ? tree->nodes_[parent].first_child : StructureTree::kNone) {}
+
+uint32_t StructureBuilder::match(std::string_view label, bool branch) {
+    std::vector<StructureTree::Node>& nodes = tree_->nodes_;
+    uint32_t index = cursor_;
+    if (index != StructureTree::kNone && nodes[index].branch == branch && nodes[index].label == label) {
+        cursor_ = nodes[index].next_sibling;
+    } else {
+        // Shape changed here: splice a fresh node in front of the cursor and
+        // leave the unmatched ones for sweep().
+        index = tree_->allocate();
+        StructureTree::Node& node = tree_->nodes_[index];
+        node.label.assign(label.data(), label.size());
+        node.value.reset();
+        node.branch = branch;
+        node.first_child = StructureTree::kNone;
+        node.next_sibling = cursor_;
+        node.dirty = true;
+        if (prev_ == StructureTree::kNone) {
+            tree_->nodes_[parent_].first_child = index;
+        } else {
+            tree_->nodes_[prev_].next_sibling = index;
+        }
     }
-    nodes_->push_back(StructureNode{label, ScalarValue{value}, {}});
+    tree_->nodes_[index].stamp = tree_->stamp_;
+    prev_ = index;
+    return index;
 }
 
-void StructureBuilder::field(const std::string& label, bool value) {
-    if (!nodes_) {
+void StructureBuilder::put(std::string_view label, ScalarValue value) {
+    if (!tree_) {
         return;
     }
-    nodes_->push_back(StructureNode{label, ScalarValue{value}, {}});
+    StructureTree::Node& node = tree_->nodes_[match(label, false)];
+    if (!node.value.has_value() || *node.value != value) {
+        node.value = std::move(value);
+        node.dirty = true;
+    }
 }
 
-void StructureBuilder::field(const std::string& label, std::string value) {
-    if (!nodes_) {
+void StructureBuilder::field(std::string_view label, int value) {
+    put(label, static_cast<int64_t>(value));
+}
+
+void StructureBuilder::field(std::string_view label, int64_t value) {
+    put(label, value);
+}
+
+void StructureBuilder::field(std::string_view label, float value) {
+    put(label, static_cast<double>(value));
+}
+
+void StructureBuilder::field(std::string_view label, double value) {
+    put(label, value);
+}
+
+void StructureBuilder::field(std::string_view label, bool value) {
+    put(label, value);
+}
+
+void StructureBuilder::field(std::string_view label, std::string value) {
+    put(label, std::move(value));
+}
+
+void StructureBuilder::field(std::string_view label, const char* value) {
+    put(label, std::string(value));
+}
+
+StructureBuilder StructureBuilder::nested(std::string_view label) {
+    if (!tree_) {
+        return StructureBuilder(nullptr, 0);
+    }
+    return StructureBuilder(tree_, match(label, true));
+}
+
+QuantileSketch::QuantileSketch() : QuantileSketch(HistogramConfig{}) {}
+
+QuantileSketch::QuantileSketch(const HistogramConfig& config) : config_(config) {
+    // config() reports what was asked for; only the derived bucket grid is
+    // sanitised.
+    const double accuracy = std::clamp(config.relative_accuracy, 1e-4, 0.5);
+    const double min_value = config.min_value > 0.0 ? config.min_value : 1e-6;
+    const double max_value = std::max(config.max_value, min_value);
+    gamma_ = (1.0 + accuracy) / (1.0 - accuracy);
+    log_gamma_ = std::log(gamma_);
+    min_index_ = static_cast<int32_t>(std::ceil(std::log(min_value) / log_gamma_));
+    max_index_ = static_cast<int32_t>(std::ceil(std::log(max_value) / log_gamma_));
+}
+
+const HistogramConfig& QuantileSketch::config() const {
+    return config_;
+}
+
+bool QuantileSketch::same_config(const HistogramConfig& config) const {
+    return config_.relative_accuracy == config.relative_accuracy && config_.min_value == config.min_value &&
+           config_.max_value == config.max_value;
+}
+
+void QuantileSketch::add(double value, uint64_t count) {
+    if (count == 0 || std::isnan(value)) {
         return;
     }
-    nodes_->push_back(StructureNode{label, ScalarValue{std::move(value)}, {}});
+    if (value > 0.0) {
+        const int32_t index = index_of(value);
+        grow_to(index);
+        counts_[static_cast<size_t>(index - first_index_)] += count;
+    } else {
+        zero_count_ += count;
+    }
+    min_ = count_ == 0 ? value : std::min(min_, value);
+    max_ = count_ == 0 ? value : std::max(max_, value);
+    count_ += count;
+    sum_ += value * static_cast<double>(count);
+}
+
+bool QuantileSketch::merge(const QuantileSketch& other) {
+    if (!same_config(other.config_)) {
+        return false;
+    }
+    if (other.empty()) {
+        return true;
+    }
+    if (!other.counts_.empty()) {
+        grow_to(other.first_index_);
+        grow_to(other.first_index_ + static_cast<int32_t>(other.counts_.size()) - 1);
+        const size_t offset = static_cast<size_t>(other.first_index_ - first_index_);
+        for (size_t i = 0; i < other.counts_.size(); ++i) {
+            counts_[offset + i] += other.counts_[i];
+        }
+    }
+    zero_count_ += other.zero_count_;
+    min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+    max_ = count_ == 0 ? other.max_ : std::max(max_, other.max_);
+    count_ += other.count_;
+    sum_ += other.sum_;
+    return true;
+}
+
+void QuantileSketch::clear() {
+    first_index_ = 0;
+    counts_.clear();
+    zero_count_ = 0;
+    count_ = 0;
+    sum_ = 0.0;
+    min_ = 0.0;
+    max_ = 0.0;
+}
+
+uint64_t QuantileSketch::count() const {
+    return count_;
+}
+
+bool QuantileSketch::empty() const {
+    return count_ == 0;
+}
+
+double QuantileSketch::sum() const {
+    return sum_;
+}
+
+double QuantileSketch::mean() const {
+    return count_ == 0 ? 0.0 : sum_ / static_cast<double>(count_);
+}
+
+double QuantileSketch::min() const {
+    return min_;
+}
+
+double QuantileSketch::max() const {
+    return max_;
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(count_ - 1));
+    uint64_t seen = zero_count_;
+    if (rank < seen) {
+        return std::clamp(0.0, min_, max_);
+    }
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (rank < seen) {
+            // The exact extremes beat a bucket midpoint at either end.
+            return std::clamp(bucket_value(first_index_ + static_cast<int32_t>(i)), min_, max_);
+        }
+    }
+    return max_;
 }
 
-void StructureBuilder::field(const std::string& label, const char* value) {
-    field(label, std::string(value));
+uint64_t QuantileSketch::zero_count() const {
+    return zero_count_;
 }
 
-StructureBuilder StructureBuilder::nested(const std::string& label) {
-    if (!nodes_) {
-        return StructureBuilder(nullptr);
+int32_t QuantileSketch::first_index() const {
+    return first_index_;
+}
+
+const std::vector<uint64_t>& QuantileSketch::counts() const {
+    return counts_;
+}
+
+double QuantileSketch::bucket_value(int32_t index) const {
+    return 2.0 * std::exp(static_cast<double>(index) * log_gamma_) / (gamma_ + 1.0);
+}
+
+bool QuantileSketch::restore(uint64_t zero_count,
+                             int32_t first_index,
+                             std::vector<uint64_t> counts,
+                             double sum,
+                             double min,
+                             double max) {
+    clear();
+    if (!counts.empty() && (first_index < min_index_ || first_index > max_index_ ||
+                            counts.size() > static_cast<size_t>(max_index_ - first_index) + 1)) {
+        return false;
+    }
+    uint64_t total = zero_count;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    first_index_ = first_index;
+    counts_ = std::move(counts);
+    zero_count_ = zero_count;
+    count_ = total;
+    sum_ = sum;
+    min_ = min;
+    max_ = max;
+    return true;
+}
+
+size_t QuantileSketch::memory_bytes() const {
+    return counts_.capacity() * sizeof(uint64_t);
+}
+
+int32_t QuantileSketch::index_of(double value) const {
+    const int32_t index = static_cast<int32_t>(std::ceil(std::log(value) / log_gamma_));
+    return std::clamp(index, min_index_, max_index_);
+}
+
+void QuantileSketch::grow_to(int32_t index) {
+    if (counts_.empty()) {
+        first_index_ = index;
+        counts_.assign(1, 0);
+    } else if (index < first_index_) {
+        counts_.insert(counts_.begin(), static_cast<size_t>(first_index_ - index), 0);
+        first_index_ = index;
+    } else if (index >= first_index_ + static_cast<int32_t>(counts_.size())) {
+        counts_.resize(static_cast<size_t>(index - first_index_) + 1, 0);
     }
-    nodes_->push_back(StructureNode{label, std::nullopt, {}});
-    return StructureBuilder(&nodes_->back().children);
 }
 
 DebugVisualizer::Graph::AssignmentProxy::AssignmentProxy(Graph* owner) : owner_(owner) {}
@@ -128,92 +466,654 @@ void DebugVisualizer::Graph::AssignmentProxy::reset(Graph* owner) {
     owner_ = owner;
 }
 
-DebugVisualizer::Graph::Graph() : x(this), config_(), samples_(), latest_sample_(0.0f) {}
+void DebugVisualizer::SlidingRange::push(uint64_t sequence, float value) {
+    if (std::isnan(value)) {
+        return;
+    }
+    while (!min_.empty() && min_.back().second >= value) {
+        min_.pop_back();
+    }
+    min_.emplace_back(sequence, value);
+    while (!max_.empty() && max_.back().second <= value) {
+        max_.pop_back();
+    }
+    max_.emplace_back(sequence, value);
+}
+
+void DebugVisualizer::SlidingRange::evict_before(uint64_t sequence) {
+    while (!min_.empty() && min_.front().first < sequence) {
+        min_.pop_front();
+    }
+    while (!max_.empty() && max_.front().first < sequence) {
+        max_.pop_front();
+    }
+}
+
+void DebugVisualizer::SlidingRange::clear() {
+    min_.clear();
+    max_.clear();
+}
 
-DebugVisualizer::Graph::Graph(GraphConfig config) : x(this), config_(config), samples_(), latest_sample_(0.0f) {}
+bool DebugVisualizer::SlidingRange::empty() const {
+    return min_.empty();
+}
+
+float DebugVisualizer::SlidingRange::min() const {
+    return min_.empty() ? 0.0f : min_.front().second;
+}
+
+float DebugVisualizer::SlidingRange::max() const {
+    return max_.empty() ? 0.0f : max_.front().second;
+}
+
+size_t DebugVisualizer::SlidingRange::memory_bytes() const {
+    return (min_.size() + max_.size()) * sizeof(std::pair<uint64_t, float>);
+}
+
+DebugVisualizer::Graph::Graph()
+        : x(this), config_(), ring_(), start_(0), pushed_(0), range_(), lod_(), latest_sample_(0.0f) {}
+
+DebugVisualizer::Graph::Graph(GraphConfig config)
+        : x(this), config_(config), ring_(), start_(0), pushed_(0), range_(), lod_(), latest_sample_(0.0f) {
+    rebuild_lod();
+}
 
 DebugVisualizer::Graph::Graph(const Graph& other)
         : x(this),
           config_(other.config_),
-          samples_(other.samples_),
+          ring_(other.ring_),
+          start_(other.start_),
+          pushed_(other.pushed_),
+          range_(other.range_),
+          lod_(other.lod_),
           latest_sample_(other.latest_sample_) {}
 
 DebugVisualizer::Graph::Graph(Graph&& other) noexcept
         : x(this),
           config_(std::move(other.config_)),
-          samples_(std::move(other.samples_)),
-          latest_sample_(other.latest_sample_) {}
+          ring_(std::move(other.ring_)),
+          start_(other.start_),
+          pushed_(other.pushed_),
+          range_(std::move(other.range_)),
+          lod_(std::move(other.lod_)),
+          latest_sample_(other.latest_sample_) {
+    other.start_ = 0;
+    other.pushed_ = 0;
+}
 
 DebugVisualizer::Graph& DebugVisualizer::Graph::operator=(const Graph& other) {
     if (this == &other) {
         return *this;
     }
-    config_ = other.config_;
-    samples_ = other.samples_;
-    latest_sample_ = other.latest_sample_;
-    x.reset(this);
-    return *this;
+    config_ = other.config_;
+    ring_ = other.ring_;
+    start_ = other.start_;
+    pushed_ = other.pushed_;
+    range_ = other.range_;
+    lod_ = other.lod_;
+    latest_sample_ = other.latest_sample_;
+    x.reset(this);
+    return *this;
+}
+
+DebugVisualizer::Graph& DebugVisualizer::Graph::operator=(Graph&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    config_ = std::move(other.config_);
+    ring_ = std::move(other.ring_);
+    start_ = other.start_;
+    pushed_ = other.pushed_;
+    range_ = std::move(other.range_);
+    lod_ = std::move(other.lod_);
+    other.start_ = 0;
+    other.pushed_ = 0;
+    latest_sample_ = other.latest_sample_;
+    x.reset(this);
+    return *this;
+}
+
+DebugVisualizer::Graph& DebugVisualizer::Graph::configure(const GraphConfig& config) {
+    const bool lod_changed =
+        config.level_of_detail != config_.level_of_detail || config.max_samples != config_.max_samples;
+    config_ = config;
+    trim_to_config();
+    if (lod_changed) {
+        rebuild_lod();
+    }
+    return *this;
+}
+
+const GraphConfig& DebugVisualizer::Graph::config() const {
+    return config_;
+}
+
+GraphConfig& DebugVisualizer::Graph::config() {
+    return config_;
+}
+
+void DebugVisualizer::Graph::push(float sample) {
+    latest_sample_ = sample;
+    if (config_.max_samples == 0) {
+        return;
+    }
+    if (!lod_.empty()) {
+        push_lod(pushed_, sample);
+    }
+    range_.push(pushed_++, sample);
+    // The ring grows up to max_samples and then overwrites its oldest slot.
+    if (ring_.size() < config_.max_samples) {
+        ring_.push_back(sample);
+        return;
+    }
+    ring_[start_] = sample;
+    start_ = start_ + 1 == ring_.size() ? 0 : start_ + 1;
+    range_.evict_before(pushed_ - ring_.size());
+}
+
+void DebugVisualizer::Graph::add_samples(const float* samples, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    latest_sample_ = samples[count - 1];
+    const size_t capacity = config_.max_samples;
+    if (capacity == 0) {
+        return;
+    }
+    if (count >= capacity) {
+        // The block alone fills the ring; everything older is evicted.
+        const float* kept = samples + (count - capacity);
+        ring_.assign(kept, kept + capacity);
+        start_ = 0;
+        pushed_ += count;
+        rebuild_range();
+        rebuild_lod();
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!lod_.empty()) {
+            push_lod(pushed_ + i, samples[i]);
+        }
+        range_.push(pushed_ + i, samples[i]);
+    }
+    pushed_ += count;
+    // A ring that is still growing always starts at slot 0.
+    if (ring_.size() < capacity) {
+        const size_t grow = std::min(capacity - ring_.size(), count);
+        ring_.insert(ring_.end(), samples, samples + grow);
+        samples += grow;
+        count -= grow;
+    }
+    while (count > 0) {
+        const size_t chunk = std::min(count, ring_.size() - start_);
+        std::memcpy(ring_.data() + start_, samples, chunk * sizeof(float));
+        start_ = start_ + chunk == ring_.size() ? 0 : start_ + chunk;
+        samples += chunk;
+        count -= chunk;
+    }
+    range_.evict_before(pushed_ - ring_.size());
+}
+
+void DebugVisualizer::Graph::add_samples(const std::vector<float>& samples) {
+    add_samples(samples.data(), samples.size());
+}
+
+void DebugVisualizer::Graph::add_samples(std::vector<float>&& samples) {
+    if (!ring_.empty() || samples.empty() || samples.size() > config_.max_samples) {
+        add_samples(samples.data(), samples.size());
+        return;
+    }
+    latest_sample_ = samples.back();
+    ring_ = std::move(samples);
+    start_ = 0;
+    pushed_ += ring_.size();
+    rebuild_range();
+    rebuild_lod();
+}
+
+std::vector<float> DebugVisualizer::Graph::samples() const {
+    std::vector<float> linear;
+    linear.reserve(ring_.size());
+    using difference_type = std::vector<float>::difference_type;
+    const auto split = ring_.begin() + static_cast<difference_type>(start_);
+    linear.insert(linear.end(), split, ring_.end());
+    linear.insert(linear.end(), ring_.begin(), split);
+    return linear;
+}
+
+size_t DebugVisualizer::Graph::size() const {
+    return ring_.size();
+}
+
+bool DebugVisualizer::Graph::empty() const {
+    return ring_.empty();
+}
+
+float DebugVisualizer::Graph::sample(size_t index) const {
+    const size_t slot = start_ + index;
+    return ring_[slot < ring_.size() ? slot : slot - ring_.size()];
+}
+
+float DebugVisualizer::Graph::latest() const {
+    return latest_sample_;
+}
+
+uint64_t DebugVisualizer::Graph::pushed() const {
+    return pushed_;
+}
+
+float DebugVisualizer::Graph::min_sample() const {
+    return range_.min();
+}
+
+float DebugVisualizer::Graph::max_sample() const {
+    return range_.max();
+}
+
+const float* DebugVisualizer::Graph::data() const {
+    return ring_.data();
+}
+
+size_t DebugVisualizer::Graph::offset() const {
+    return start_;
+}
+
+void DebugVisualizer::Graph::trim_to_config() {
+    if (config_.max_samples == 0) {
+        ring_.clear();
+        start_ = 0;
+        range_.clear();
+        return;
+    }
+    if (start_ == 0 && ring_.size() <= config_.max_samples) {
+        return;
+    }
+    std::vector<float> linear = samples();
+    if (linear.size() > config_.max_samples) {
+        const size_t excess = linear.size() - config_.max_samples;
+        using difference_type = std::vector<float>::difference_type;
+        linear.erase(linear.begin(), linear.begin() + static_cast<difference_type>(excess));
+    }
+    ring_ = std::move(linear);
+    start_ = 0;
+    rebuild_range();
+}
+
+size_t DebugVisualizer::Graph::lod_levels() const {
+    return lod_.size() + 1;
+}
+
+uint64_t DebugVisualizer::Graph::lod_first_bucket(size_t level) const {
+    const uint64_t oldest = pushed_ - ring_.size();
+    const uint64_t width = uint64_t{1} << level;
+    return (oldest + width - 1) >> level;
+}
+
+size_t DebugVisualizer::Graph::lod_bucket_count(size_t level) const {
+    if (level == 0) {
+        return ring_.size();
+    }
+    if (level > lod_.size() || ring_.empty()) {
+        return 0;
+    }
+    const uint64_t last = (pushed_ - 1) >> level;
+    const uint64_t first = lod_first_bucket(level);
+    return last < first ? 0 : static_cast<size_t>(last - first + 1);
+}
+
+std::pair<float, float> DebugVisualizer::Graph::lod_bucket(size_t level, size_t index) const {
+    if (level == 0) {
+        const float value = sample(index);
+        return {value, value};
+    }
+    const auto& buckets = lod_[level - 1];
+    return buckets[(lod_first_bucket(level) + index) % buckets.size()];
+}
+
+size_t DebugVisualizer::Graph::plot_level(size_t columns) const {
+    if (ring_.size() <= columns) {
+        return 0;
+    }
+    size_t level = 1;
+    while (level + 1 < lod_levels() && 2 * lod_bucket_count(level) > columns) {
+        ++level;
+    }
+    return level < lod_levels() ? level : 0;
+}
+
+void DebugVisualizer::Graph::plot_values(size_t columns, std::vector<float>& out) const {
+    out.clear();
+    const size_t level = plot_level(columns);
+    if (level > 0) {
+        const size_t buckets = lod_bucket_count(level);
+        out.reserve(buckets * 2);
+        for (size_t i = 0; i < buckets; ++i) {
+            const auto [low, high] = lod_bucket(level, i);
+            out.push_back(low);
+            out.push_back(high);
+        }
+        return;
+    }
+    const size_t count = ring_.size();
+    if (count <= columns) {
+        out.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            out.push_back(sample(i));
+        }
+        return;
+    }
+    // ImGui::PlotLines' resampling: one segment per column.
+    const int segments = static_cast<int>(std::max<size_t>(columns, 2)) - 1;
+    const int items = static_cast<int>(count) - 1;
+    const float step = 1.0f / static_cast<float>(segments);
+    float t = 0.0f;
+    out.reserve(static_cast<size_t>(segments) + 1);
+    out.push_back(sample(0));
+    for (int n = 0; n < segments; ++n) {
+        const int index = static_cast<int>(t * static_cast<float>(items) + 0.5f);
+        t += step;
+        out.push_back(sample(static_cast<size_t>(std::min(index + 1, items))));
+    }
+}
+
+void DebugVisualizer::Graph::push_lod(uint64_t sequence, float value) {
+    for (size_t level = 1; level <= lod_.size(); ++level) {
+        auto& buckets = lod_[level - 1];
+        auto& bucket = buckets[(sequence >> level) % buckets.size()];
+        const uint64_t mask = (uint64_t{1} << level) - 1;
+        if ((sequence & mask) == 0) {
+            bucket = {value, value};
+        } else if (!std::isnan(value)) {
+            bucket.first = std::min(bucket.first, value);
+            bucket.second = std::max(bucket.second, value);
+        }
+    }
+}
+
+void DebugVisualizer::Graph::rebuild_lod() {
+    lod_.clear();
+    if (!config_.level_of_detail) {
+        return;
+    }
+    // Bucket rings hold one spare slot each for the partially retained oldest
+    // bucket and the still-filling newest one.
+    for (size_t level = 1; (config_.max_samples >> level) >= kMinLodBuckets; ++level) {
+        lod_.emplace_back((config_.max_samples >> level) + 2);
+    }
+    const uint64_t first = pushed_ - ring_.size();
+    for (size_t i = 0; i < ring_.size(); ++i) {
+        push_lod(first + i, sample(i));
+    }
+}
+
+size_t DebugVisualizer::Graph::memory_bytes() const {
+    size_t bytes = ring_.capacity() * sizeof(float) + range_.memory_bytes();
+    for (const auto& level : lod_) {
+        bytes += level.capacity() * sizeof(level[0]);
+    }
+    return bytes;
+}
+
+void DebugVisualizer::Graph::rebuild_range() {
+    range_.clear();
+    const uint64_t first = pushed_ - ring_.size();
+    for (size_t i = 0; i < ring_.size(); ++i) {
+        range_.push(first + i, sample(i));
+    }
+}
+
+DebugVisualizer::TimeSeries::TimeSeries() = default;
+
+DebugVisualizer::TimeSeries::TimeSeries(TimeSeriesConfig config) : config_(std::move(config)) {}
+
+DebugVisualizer::TimeSeries& DebugVisualizer::TimeSeries::configure(const TimeSeriesConfig& config) {
+    config_ = config;
+    if (columns_ == 0) {
+        // Storage is laid out by the first sample.
+        return *this;
+    }
+    const size_t columns = config_.series.empty() ? columns_ : config_.series.size();
+    if (columns != columns_ || config_.max_samples != capacity_) {
+        relayout(columns, config_.max_samples);
+    }
+    if (config_.time_window > 0.0 && size_ > 0) {
+        const double horizon = latest_time() - config_.time_window;
+        size_t expired = 0;
+        while (expired < size_ && times_[slot(expired)] < horizon) {
+            ++expired;
+        }
+        evict_front(expired);
+    }
+    return *this;
+}
+
+const TimeSeriesConfig& DebugVisualizer::TimeSeries::config() const {
+    return config_;
+}
+
+void DebugVisualizer::TimeSeries::push(double time, const float* values, size_t count) {
+    if (columns_ == 0) {
+        const size_t columns = config_.series.empty() ? count : config_.series.size();
+        if (columns == 0) {
+            return;
+        }
+        relayout(columns, config_.max_samples);
+    }
+    if (capacity_ == 0) {
+        return;
+    }
+    if (size_ > 0) {
+        time = std::max(time, latest_time());
+    }
+    if (size_ == capacity_) {
+        evict_front(1);
+    }
+
+    const size_t at = slot(size_);
+    times_[at] = time;
+    for (size_t column = 0; column < columns_; ++column) {
+        const float sample = column < count ? values[column] : std::numeric_limits<float>::quiet_NaN();
+        values_[column * capacity_ + at] = sample;
+        range_.push(pushed_, sample);
+    }
+    ++size_;
+    ++pushed_;
+
+    if (config_.time_window > 0.0) {
+        // Rows are time-ordered, so the expired ones are a prefix.
+        const double horizon = time - config_.time_window;
+        size_t expired = 0;
+        while (expired < size_ && times_[slot(expired)] < horizon) {
+            ++expired;
+        }
+        evict_front(expired);
+    }
+}
+
+void DebugVisualizer::TimeSeries::push(double time, std::initializer_list<float> values) {
+    push(time, values.begin(), values.size());
+}
+
+size_t DebugVisualizer::TimeSeries::size() const {
+    return size_;
+}
+
+bool DebugVisualizer::TimeSeries::empty() const {
+    return size_ == 0;
+}
+
+size_t DebugVisualizer::TimeSeries::series_count() const {
+    return columns_ == 0 ? config_.series.size() : columns_;
+}
+
+std::string DebugVisualizer::TimeSeries::series_label(size_t series) const {
+    return series < config_.series.size() ? config_.series[series] : std::to_string(series);
+}
+
+double DebugVisualizer::TimeSeries::time(size_t index) const {
+    return index < size_ ? times_[slot(index)] : 0.0;
+}
+
+float DebugVisualizer::TimeSeries::value(size_t series, size_t index) const {
+    if (series >= columns_ || index >= size_) {
+        return 0.0f;
+    }
+    return values_[series * capacity_ + slot(index)];
+}
+
+double DebugVisualizer::TimeSeries::latest_time() const {
+    return size_ == 0 ? 0.0 : times_[slot(size_ - 1)];
+}
+
+float DebugVisualizer::TimeSeries::min_value() const {
+    return range_.min();
+}
+
+float DebugVisualizer::TimeSeries::max_value() const {
+    return range_.max();
+}
+
+size_t DebugVisualizer::TimeSeries::memory_bytes() const {
+    return times_.capacity() * sizeof(double) + values_.capacity() * sizeof(float) + range_.memory_bytes();
+}
+
+void DebugVisualizer::TimeSeries::relayout(size_t columns, size_t capacity) {
+    const size_t kept = columns == columns_ ? std::min(size_, capacity) : 0;
+    const size_t first = size_ - kept;
+    std::vector<double> times(capacity);
+    std::vector<float> values(capacity * columns);
+    for (size_t i = 0; i < kept; ++i) {
+        const size_t from = slot(first + i);
+        times[i] = times_[from];
+        for (size_t column = 0; column < columns; ++column) {
+            values[column * capacity + i] = values_[column * capacity_ + from];
+        }
+    }
+    times_ = std::move(times);
+    values_ = std::move(values);
+    columns_ = columns;
+    capacity_ = capacity;
+    start_ = 0;
+    size_ = kept;
+    rebuild_range();
+}
+
+void DebugVisualizer::TimeSeries::evict_front(size_t rows) {
+    if (rows == 0) {
+        return;
+    }
+    start_ = slot(rows);
+    size_ -= rows;
+    range_.evict_before(pushed_ - size_);
+}
+
+void DebugVisualizer::TimeSeries::rebuild_range() {
+    range_.clear();
+    const uint64_t first = pushed_ - size_;
+    for (size_t i = 0; i < size_; ++i) {
+        for (size_t column = 0; column < columns_; ++column) {
+            range_.push(first + i, value(column, i));
+        }
+    }
+}
+
+size_t DebugVisualizer::TimeSeries::slot(size_t index) const {
+    const size_t at = start_ + index;
+    return at >= capacity_ ? at - capacity_ : at;
+}
+
+DebugVisualizer::ZoneTimeline::ZoneTimeline(double window, size_t max_zones)
+        : window_(window), max_zones_(std::max<size_t>(max_zones, 1)) {}
+
+uint32_t DebugVisualizer::ZoneTimeline::name_id(const std::string& name) {
+    auto it = name_ids_.find(name);
+    if (it != name_ids_.end()) {
+        return it->second;
+    }
+    const uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.push_back(name);
+    name_ids_.emplace(name, id);
+    return id;
 }
 
-DebugVisualizer::Graph& DebugVisualizer::Graph::operator=(Graph&& other) noexcept {
-    if (this == &other) {
-        return *this;
+uint32_t DebugVisualizer::ZoneTimeline::lane_id(const std::string& label) {
+    auto it = std::find(lanes_.begin(), lanes_.end(), label);
+    if (it != lanes_.end()) {
+        return static_cast<uint32_t>(it - lanes_.begin());
     }
-    config_ = std::move(other.config_);
-    samples_ = std::move(other.samples_);
-    latest_sample_ = other.latest_sample_;
-    x.reset(this);
-    return *this;
+    lanes_.push_back(label);
+    lane_depths_.push_back(0);
+    return static_cast<uint32_t>(lanes_.size() - 1);
 }
 
-DebugVisualizer::Graph& DebugVisualizer::Graph::configure(const GraphConfig& config) {
-    config_ = config;
-    trim_to_config();
-    return *this;
+const std::string& DebugVisualizer::ZoneTimeline::name(uint32_t id) const {
+    return names_[id];
 }
 
-const GraphConfig& DebugVisualizer::Graph::config() const {
-    return config_;
+const std::string& DebugVisualizer::ZoneTimeline::lane_label(uint32_t id) const {
+    return lanes_[id];
 }
 
-GraphConfig& DebugVisualizer::Graph::config() {
-    return config_;
+size_t DebugVisualizer::ZoneTimeline::lane_count() const {
+    return lanes_.size();
 }
 
-void DebugVisualizer::Graph::push(float sample) {
-    latest_sample_ = sample;
-    samples_.push_back(sample);
-    trim_to_config();
+uint32_t DebugVisualizer::ZoneTimeline::lane_depth(uint32_t lane) const {
+    return lane < lane_depths_.size() ? lane_depths_[lane] : 0;
 }
 
-void DebugVisualizer::Graph::add_samples(const std::vector<float>& samples) {
-    for (float sample : samples) {
-        push(sample);
+void DebugVisualizer::ZoneTimeline::push(const Zone& zone) {
+    if (zone.lane >= lanes_.size() || zone.name >= names_.size()) {
+        return;
+    }
+    lane_depths_[zone.lane] = std::max(lane_depths_[zone.lane], zone.depth + 1);
+    latest_ = std::max(latest_, zone.end);
+    zones_.push_back(zone);
+    while (zones_.size() > max_zones_ || zones_.front().end < latest_ - window_) {
+        zones_.pop_front();
     }
 }
 
-const std::vector<float>& DebugVisualizer::Graph::samples() const {
-    return samples_;
+void DebugVisualizer::ZoneTimeline::clear() {
+    zones_.clear();
+    names_.clear();
+    name_ids_.clear();
+    lanes_.clear();
+    lane_depths_.clear();
+    latest_ = 0.0;
 }
 
-std::vector<float>& DebugVisualizer::Graph::samples() {
-    return samples_;
+const std::deque<DebugVisualizer::ZoneTimeline::Zone>& DebugVisualizer::ZoneTimeline::zones() const {
+    return zones_;
 }
 
-float DebugVisualizer::Graph::latest() const {
-    return latest_sample_;
+size_t DebugVisualizer::ZoneTimeline::size() const {
+    return zones_.size();
 }
 
-void DebugVisualizer::Graph::trim_to_config() {
-    if (config_.max_samples == 0) {
-        samples_.clear();
-        return;
+bool DebugVisualizer::ZoneTimeline::empty() const {
+    return zones_.empty();
+}
+
+double DebugVisualizer::ZoneTimeline::window() const {
+    return window_;
+}
+
+double DebugVisualizer::ZoneTimeline::latest_time() const {
+    return latest_;
+}
+
+size_t DebugVisualizer::ZoneTimeline::memory_bytes() const {
+    size_t bytes = zones_.size() * sizeof(Zone) + lane_depths_.capacity() * sizeof(uint32_t);
+    for (const auto& name : names_) {
+        // Held by both names_ and name_ids_.
+        bytes += 2 * name.capacity();
     }
-    if (samples_.size() > config_.max_samples) {
-        const size_t excess = samples_.size() - config_.max_samples;
-        using difference_type = std::vector<float>::difference_type;
-        samples_.erase(samples_.begin(), samples_.begin() + static_cast<difference_type>(excess));
+    for (const auto& lane : lanes_) {
+        bytes += lane.capacity();
     }
+    return bytes;
 }
 
 DebugVisualizer::Tab::Tab(std::string id, std::string title)
@@ -221,6 +1121,19 @@ DebugVisualizer::Tab::Tab(std::string id, std::string title)
           id_(std::move(id)),
           title_(title.empty() ? id_ : std::move(title)) {}
 
+std::optional<ScalarValue> TabSnapshot::get_scalar(std::string_view key) const {
+    auto it = scalars.find(key);
+    if (it == scalars.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::shared_ptr<const std::vector<float>> TabSnapshot::get_graph_samples(std::string_view key) const {
+    auto it = graphs.find(key);
+    return it == graphs.end() ? nullptr : it->second.samples;
+}
+
 DebugVisualizer::TabCollection::TabCollection(DebugVisualizer* owner) : owner_(owner) {}
 
 DebugVisualizer::Tab& DebugVisualizer::TabCollection::operator[](const std::string& id) {
@@ -246,6 +1159,13 @@ std::vector<std::string> DebugVisualizer::TabCollection::ids() const {
     return owner_->tab_ids();
 }
 
+void DebugVisualizer::ScalarEntry::set(ScalarValue next) {
+    if (next != value) {
+        value = std::move(next);
+        dirty = true;
+    }
+}
+
 DebugVisualizer::Tab::GraphCollection::GraphCollection(Tab* owner) : owner_(owner) {}
 
 DebugVisualizer::Graph& DebugVisualizer::Tab::GraphCollection::operator[](const std::string& key) {
@@ -308,7 +1228,7 @@ DebugVisualizer::Tab& DebugVisualizer::Tab::update_value(const std::string& key,
 }
 
 DebugVisualizer::Tab& DebugVisualizer::Tab::update_value(const std::string& key, int64_t value) {
-    scalars_[key] = value;
+    scalars_[key].set(value);
     return *this;
 }
 
@@ -317,7 +1237,8 @@ DebugVisualizer::Graph& DebugVisualizer::Tab::ensure_graph(const std::string& ke
     if (!inserted) {
         const GraphConfig& existing = it->second.config();
         if (existing.max_samples != config.max_samples || existing.auto_scale != config.auto_scale ||
-            existing.manual_min != config.manual_min || existing.manual_max != config.manual_max) {
+            existing.manual_min != config.manual_min || existing.manual_max != config.manual_max ||
+            existing.level_of_detail != config.level_of_detail) {
             it->second.configure(config);
         }
     }
@@ -329,22 +1250,22 @@ DebugVisualizer::Tab& DebugVisualizer::Tab::update_value(const std::string& key,
 }
 
 DebugVisualizer::Tab& DebugVisualizer::Tab::update_value(const std::string& key, double value) {
-    scalars_[key] = value;
+    scalars_[key].set(value);
     return *this;
 }
 
 DebugVisualizer::Tab& DebugVisualizer::Tab::update_value(const std::string& key, bool value) {
-    scalars_[key] = value;
+    scalars_[key].set(value);
     return *this;
 }
 
 DebugVisualizer::Tab& DebugVisualizer::Tab::update_value(const std::string& key, std::string value) {
-    scalars_[key] = std::move(value);
+    scalars_[key].set(std::move(value));
     return *this;
 }
 
 DebugVisualizer::Tab& DebugVisualizer::Tab::update_value(const std::string& key, const char* value) {
-    scalars_[key] = std::string(value);
+    scalars_[key].set(std::string(value));
     return *this;
 }
 
@@ -362,27 +1283,134 @@ DebugVisualizer::Tab& DebugVisualizer::Tab::add_graph_samples(const std::string&
     return *this;
 }
 
+DebugVisualizer::Tab& DebugVisualizer::Tab::add_graph_samples(const std::string& key,
+                                                              std::vector<float>&& samples,
+                                                              const GraphConfig& config) {
+    DebugVisualizer::Graph& graph = ensure_graph(key, config);
+    graph.add_samples(std::move(samples));
+    return *this;
+}
+
+DebugVisualizer::Tab& DebugVisualizer::Tab::add_graph_samples(const std::string& key,
+                                                              const float* samples,
+                                                              size_t count,
+                                                              const GraphConfig& config) {
+    DebugVisualizer::Graph& graph = ensure_graph(key, config);
+    graph.add_samples(samples, count);
+    return *this;
+}
+
+DebugVisualizer::Tab& DebugVisualizer::Tab::configure_series(const std::string& key, const TimeSeriesConfig& config) {
+    series_[key].configure(config);
+    return *this;
+}
+
+DebugVisualizer::Tab& DebugVisualizer::Tab::push_series_sample(const std::string& key,
+                                                               double time,
+                                                               const float* values,
+                                                               size_t count) {
+    series_[key].push(time, values, count);
+    return *this;
+}
+
+DebugVisualizer::Tab& DebugVisualizer::Tab::push_series_sample(const std::string& key,
+                                                               double time,
+                                                               std::initializer_list<float> values) {
+    series_[key].push(time, values);
+    return *this;
+}
+
+DebugVisualizer::Tab& DebugVisualizer::Tab::merge_histogram(const std::string& key, const QuantileSketch& sketch) {
+    auto [it, inserted] = histograms_.try_emplace(key, sketch.config());
+    if (!it->second.merge(sketch)) {
+        it->second = sketch;
+    }
+    return *this;
+}
+
+DebugVisualizer::Tab& DebugVisualizer::Tab::add_histogram_sample(const std::string& key,
+                                                                 double value,
+                                                                 const HistogramConfig& config) {
+    auto [it, inserted] = histograms_.try_emplace(key, config);
+    if (!inserted && !it->second.same_config(config)) {
+        it->second = QuantileSketch(config);
+    }
+    it->second.add(value);
+    return *this;
+}
+
+DebugVisualizer::ZoneTimeline& DebugVisualizer::Tab::zone_timeline(const std::string& key) {
+    return timelines_[key];
+}
+
 DebugVisualizer::Tab& DebugVisualizer::Tab::update_structure(const std::string& key,
                                                              const std::function<void(StructureBuilder&)>& builder) {
-    StructureEntry& entry = structures_[key];
-    entry.root.label = key;
-    entry.root.value.reset();
-    entry.root.children.clear();
+    structures_[key].tree.update(builder);
+    return *this;
+}
 
-    StructureBuilder root_builder(&entry.root.children);
-    if (builder) {
-        builder(root_builder);
+DebugVisualizer::Tab& DebugVisualizer::Tab::defer_structure(const std::string& key,
+                                                            std::function<void(StructureBuilder&)> builder) {
+    StructureEntry& entry = structures_[key];
+    if (shown_) {
+        entry.tree.update(builder);
+        return *this;
+    }
+    if (!entry.deferred) {
+        ++deferred_count_;
+    }
+    entry.deferred = std::move(builder);
+    if (!entry.deferred) {
+        // An empty builder clears the structure; keep that ordering too.
+        entry.deferred = [](StructureBuilder&) {};
     }
-    entry.has_content = !entry.root.children.empty();
     return *this;
 }
 
+bool DebugVisualizer::Tab::is_shown() const {
+    return shown_;
+}
+
+void DebugVisualizer::Tab::set_shown(bool shown) {
+    shown_ = shown;
+    if (!shown_ || deferred_count_ == 0) {
+        return;
+    }
+    for (auto& [key, entry] : structures_) {
+        if (entry.deferred) {
+            entry.tree.update(entry.deferred);
+            entry.deferred = nullptr;
+            if (!entry.shown) {
+                entry.shown = true;
+                ++shown_count_;
+            }
+        }
+    }
+    deferred_count_ = 0;
+}
+
+std::vector<std::string> DebugVisualizer::Tab::take_shown_structures() {
+    std::vector<std::string> keys;
+    if (shown_count_ == 0) {
+        return keys;
+    }
+    keys.reserve(shown_count_);
+    for (auto& [key, entry] : structures_) {
+        if (entry.shown) {
+            entry.shown = false;
+            keys.push_back(key);
+        }
+    }
+    shown_count_ = 0;
+    return keys;
+}
+
 std::optional<ScalarValue> DebugVisualizer::Tab::get_scalar(const std::string& key) const {
     auto it = scalars_.find(key);
     if (it == scalars_.end()) {
         return std::nullopt;
     }
-    return it->second;
+    return it->second.value;
 }
 
 std::vector<float> DebugVisualizer::Tab::get_graph_samples(const std::string& key) const {
@@ -395,16 +1423,171 @@ std::vector<float> DebugVisualizer::Tab::get_graph_samples(const std::string& ke
 
 std::optional<StructureNode> DebugVisualizer::Tab::get_structure(const std::string& key) const {
     auto it = structures_.find(key);
-    if (it == structures_.end() || !it->second.has_content) {
+    if (it == structures_.end()) {
+        return std::nullopt;
+    }
+    if (it->second.tree.empty()) {
         return std::nullopt;
     }
-    return it->second.root;
+    StructureNode root = it->second.tree.snapshot();
+    root.label = key;
+    return root;
+}
+
+const DebugVisualizer::Graph* DebugVisualizer::Tab::find_graph(const std::string& key) const {
+    auto it = graphs_.find(key);
+    return it == graphs_.end() ? nullptr : &it->second;
+}
+
+const DebugVisualizer::TimeSeries* DebugVisualizer::Tab::find_series(const std::string& key) const {
+    auto it = series_.find(key);
+    return it == series_.end() ? nullptr : &it->second;
+}
+
+const QuantileSketch* DebugVisualizer::Tab::find_histogram(const std::string& key) const {
+    auto it = histograms_.find(key);
+    return it == histograms_.end() ? nullptr : &it->second;
+}
+
+const DebugVisualizer::ZoneTimeline* DebugVisualizer::Tab::find_zone_timeline(const std::string& key) const {
+    auto it = timelines_.find(key);
+    return it == timelines_.end() ? nullptr : &it->second;
+}
+
+std::vector<std::string> DebugVisualizer::Tab::scalar_keys() const {
+    std::vector<std::string> keys;
+    keys.reserve(scalars_.size());
+    for (const auto& entry : scalars_) {
+        keys.push_back(entry.first);
+    }
+    return keys;
+}
+
+std::vector<std::string> DebugVisualizer::Tab::graph_keys() const {
+    std::vector<std::string> keys;
+    keys.reserve(graphs_.size());
+    for (const auto& entry : graphs_) {
+        keys.push_back(entry.first);
+    }
+    return keys;
+}
+
+std::vector<std::string> DebugVisualizer::Tab::series_keys() const {
+    std::vector<std::string> keys;
+    keys.reserve(series_.size());
+    for (const auto& entry : series_) {
+        keys.push_back(entry.first);
+    }
+    return keys;
+}
+
+std::vector<std::string> DebugVisualizer::Tab::histogram_keys() const {
+    std::vector<std::string> keys;
+    keys.reserve(histograms_.size());
+    for (const auto& entry : histograms_) {
+        keys.push_back(entry.first);
+    }
+    return keys;
+}
+
+std::vector<std::string> DebugVisualizer::Tab::zone_timeline_keys() const {
+    std::vector<std::string> keys;
+    keys.reserve(timelines_.size());
+    for (const auto& entry : timelines_) {
+        keys.push_back(entry.first);
+    }
+    return keys;
+}
+
+std::vector<std::string> DebugVisualizer::Tab::structure_keys() const {
+    std::vector<std::string> keys;
+    keys.reserve(structures_.size());
+    for (const auto& entry : structures_) {
+        keys.push_back(entry.first);
+    }
+    return keys;
+}
+
+DebugVisualizer::ScalarEntry& DebugVisualizer::Tab::scalar_slot(const std::string& key) {
+    return scalars_[key];
+}
+
+uint64_t DebugVisualizer::Tab::generation() const {
+    return generation_;
+}
+
+std::shared_ptr<const TabSnapshot> DebugVisualizer::Tab::snapshot(const TabSnapshot* previous) const {
+    auto next = std::make_shared<TabSnapshot>();
+    next->id = id_;
+    next->version = previous ? previous->version + 1 : 0;
+    next->generation = generation_;
+    for (const auto& [key, entry] : scalars_) {
+        next->scalars.emplace_hint(next->scalars.end(), key, entry.value);
+    }
+    const bool same_tab = previous && previous->id == id_ && previous->generation == generation_;
+    for (const auto& [key, graph] : graphs_) {
+        TabSnapshot::GraphSamples copy;
+        copy.pushed = graph.pushed();
+        if (same_tab) {
+            auto it = previous->graphs.find(key);
+            if (it != previous->graphs.end() && it->second.pushed == graph.pushed() &&
+                it->second.samples->size() == graph.size()) {
+                copy.samples = it->second.samples;
+            }
+        }
+        if (!copy.samples) {
+            copy.samples = std::make_shared<const std::vector<float>>(graph.samples());
+        }
+        next->graphs.emplace_hint(next->graphs.end(), key, std::move(copy));
+    }
+    return next;
+}
+
+void DebugVisualizer::Tab::refresh_rows() const {
+    if (rows_generation_ == generation_ && scalar_rows_.size() == scalars_.size() &&
+        graph_rows_.size() == graphs_.size() && series_rows_.size() == series_.size() &&
+        histogram_rows_.size() == histograms_.size()) {
+        return;
+    }
+
+    scalar_rows_.clear();
+    scalar_rows_.reserve(scalars_.size());
+    for (const auto& entry : scalars_) {
+        scalar_rows_.push_back(&entry);
+    }
+
+    graph_rows_.clear();
+    graph_rows_.reserve(graphs_.size());
+    for (const auto& entry : graphs_) {
+        graph_rows_.push_back(&entry);
+    }
+    graph_geometry_.assign(graph_rows_.size(), {});
+
+    series_rows_.clear();
+    series_rows_.reserve(series_.size());
+    for (const auto& entry : series_) {
+        series_rows_.push_back(&entry);
+    }
+
+    histogram_rows_.clear();
+    histogram_rows_.reserve(histograms_.size());
+    for (const auto& entry : histograms_) {
+        histogram_rows_.push_back(&entry);
+    }
+
+    rows_generation_ = generation_;
 }
 
 void DebugVisualizer::Tab::clear() {
+    deferred_count_ = 0;
+    shown_count_ = 0;
     scalars_.clear();
     graphs_.clear();
+    series_.clear();
+    timelines_.clear();
+    histograms_.clear();
     structures_.clear();
+    ++generation_;
 }
 
 DebugVisualizer::DebugVisualizer()
@@ -412,6 +1595,7 @@ DebugVisualizer::DebugVisualizer()
                     window_title_("Debug Window"),
           window_flags_(ImGuiWindowFlags_None),
           visible_(true),
+          defer_hidden_structures_(false),
           default_tab_id_("overview") {
     add_tab(default_tab_id_);
 }
@@ -436,6 +1620,28 @@ bool DebugVisualizer::is_visible() const {
     return visible_;
 }
 
+void DebugVisualizer::set_defer_hidden_structures(bool defer) {
+    defer_hidden_structures_ = defer;
+    for (auto& entry : window_tiles_) {
+        if (entry.visualizer) {
+            entry.visualizer->set_defer_hidden_structures(defer);
+        }
+    }
+    if (!defer) {
+        set_tabs_shown(true);
+    }
+}
+
+bool DebugVisualizer::defer_hidden_structures() const {
+    return defer_hidden_structures_;
+}
+
+void DebugVisualizer::set_tabs_shown(bool shown) {
+    for (auto& tab : tabs_) {
+        tab->set_shown(shown);
+    }
+}
+
 DebugVisualizer::Tab& DebugVisualizer::add_tab(const std::string& id) {
     return add_tab(id, id);
 }
@@ -456,13 +1662,15 @@ bool DebugVisualizer::remove_tab(const std::string& id) {
     if (id == default_tab_id_) {
         return false;
     }
-    auto it = std::find_if(tabs_.begin(), tabs_.end(), [&](const std::unique_ptr<Tab>& tab) {
-        return tab->id() == id;
-    });
-    if (it == tabs_.end()) {
+    auto indexed = tab_index_.find(id);
+    if (indexed == tab_index_.end()) {
         return false;
     }
-    tabs_.erase(it);
+    const Tab* tab = indexed->second;
+    tab_index_.erase(indexed);
+    tabs_.erase(std::find_if(tabs_.begin(), tabs_.end(), [tab](const std::unique_ptr<Tab>& entry) {
+        return entry.get() == tab;
+    }));
     return true;
 }
 
@@ -500,40 +1708,33 @@ DebugVisualizer& DebugVisualizer::window_tile(const std::string& id, const std::
     tile.visualizer = std::make_unique<DebugVisualizer>();
     tile.visualizer->set_window_title(title.empty() ? id : title);
     tile.visualizer->set_visible(true);
+    tile.visualizer->set_defer_hidden_structures(defer_hidden_structures_);
 
     DebugVisualizer& reference = *tile.visualizer;
+    window_tile_index_.emplace(id, &reference);
     window_tiles_.push_back(std::move(tile));
     return reference;
 }
 
 DebugVisualizer* DebugVisualizer::find_window_tile(const std::string& id) {
-    auto it = std::find_if(window_tiles_.begin(), window_tiles_.end(), [&](const WindowTile& entry) {
-        return entry.id == id;
-    });
-    if (it == window_tiles_.end()) {
-        return nullptr;
-    }
-    return it->visualizer.get();
+    return const_cast<DebugVisualizer*>(std::as_const(*this).find_window_tile(id));
 }
 
 const DebugVisualizer* DebugVisualizer::find_window_tile(const std::string& id) const {
-    auto it = std::find_if(window_tiles_.begin(), window_tiles_.end(), [&](const WindowTile& entry) {
-        return entry.id == id;
-    });
-    if (it == window_tiles_.end()) {
-        return nullptr;
-    }
-    return it->visualizer.get();
+    auto it = window_tile_index_.find(id);
+    return it == window_tile_index_.end() ? nullptr : it->second;
 }
 
 bool DebugVisualizer::remove_window_tile(const std::string& id) {
-    auto it = std::find_if(window_tiles_.begin(), window_tiles_.end(), [&](const WindowTile& entry) {
-        return entry.id == id;
-    });
-    if (it == window_tiles_.end()) {
+    auto indexed = window_tile_index_.find(id);
+    if (indexed == window_tile_index_.end()) {
         return false;
     }
-    window_tiles_.erase(it);
+    const DebugVisualizer* visualizer = indexed->second;
+    window_tile_index_.erase(indexed);
+    window_tiles_.erase(std::find_if(window_tiles_.begin(), window_tiles_.end(), [visualizer](const WindowTile& entry) {
+        return entry.visualizer.get() == visualizer;
+    }));
     return true;
 }
 
@@ -556,16 +1757,25 @@ void DebugVisualizer::render() {
             } else if (ImGui::BeginTabBar("DebugVisualizerTabs")) {
                 for (auto& tab_ptr : tabs_) {
                     Tab& tab = *tab_ptr;
-                    if (ImGui::BeginTabItem(tab.title().c_str())) {
+                    const bool open = ImGui::BeginTabItem(tab.title().c_str());
+                    tab.set_shown(open || !defer_hidden_structures_);
+                    if (open) {
                         render_tab_contents(tab);
                         ImGui::EndTabItem();
                     }
                 }
                 ImGui::EndTabBar();
+            } else {
+                set_tabs_shown(!defer_hidden_structures_);
             }
+        } else {
+            // Collapsed window.
+            set_tabs_shown(!defer_hidden_structures_);
         }
         ImGui::End();
         visible_ = keep_open;
+    } else {
+        set_tabs_shown(!defer_hidden_structures_);
     }
 
     for (auto& entry : window_tiles_) {
@@ -575,24 +1785,71 @@ void DebugVisualizer::render() {
     }
 }
 
+void DebugVisualizer::skip_render() {
+    set_tabs_shown(visible_ || !defer_hidden_structures_);
+    for (auto& entry : window_tiles_) {
+        if (entry.visualizer) {
+            entry.visualizer->skip_render();
+        }
+    }
+}
+
 void DebugVisualizer::render_tab_contents(const Tab& tab) const {
     bool rendered_any = false;
+    tab.refresh_rows();
 
-    if (!tab.scalars_.empty()) {
+    // Scalars and graphs go through a clipper so the cost follows the rows on
+    // screen, not the number of keys. Both kinds of row have a fixed height.
+    if (!tab.scalar_rows_.empty()) {
         ImGui::SeparatorText("Variables");
-        for (const auto& [key, value] : tab.scalars_) {
-            render_scalar(key, value);
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(tab.scalar_rows_.size()), ImGui::GetTextLineHeightWithSpacing());
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                const auto& [key, value] = *tab.scalar_rows_[static_cast<size_t>(row)];
+                render_scalar(key, value);
+            }
         }
         rendered_any = true;
     }
 
-    if (!tab.graphs_.empty()) {
+    // Multi-series plots and histograms share the graph rows, after the
+    // single-series ones.
+    const size_t graph_rows = tab.graph_rows_.size();
+    const size_t series_end = graph_rows + tab.series_rows_.size();
+    const size_t plot_rows = series_end + tab.histogram_rows_.size();
+    if (plot_rows > 0) {
         if (rendered_any) {
             ImGui::Spacing();
         }
         ImGui::SeparatorText("Graphs");
-        for (const auto& [key, graph] : tab.graphs_) {
-            render_graph(key, graph);
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(plot_rows), kGraphHeight + ImGui::GetStyle().ItemSpacing.y);
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                const size_t index = static_cast<size_t>(row);
+                if (index < graph_rows) {
+                    const auto& [key, graph] = *tab.graph_rows_[index];
+                    render_graph(key, graph, tab.graph_geometry_[index]);
+                } else if (index < series_end) {
+                    const auto& [key, series] = *tab.series_rows_[index - graph_rows];
+                    render_series(key, series);
+                } else {
+                    const auto& [key, sketch] = *tab.histogram_rows_[index - series_end];
+                    render_histogram(key, sketch);
+                }
+            }
+        }
+        rendered_any = true;
+    }
+
+    if (!tab.timelines_.empty()) {
+        if (rendered_any) {
+            ImGui::Spacing();
+        }
+        ImGui::SeparatorText("Timeline");
+        for (const auto& [key, timeline] : tab.timelines_) {
+            render_zone_timeline(key, timeline);
         }
         rendered_any = true;
     }
@@ -604,12 +1861,13 @@ void DebugVisualizer::render_tab_contents(const Tab& tab) const {
         }
         ImGui::SeparatorText("Structures");
         for (const auto& [key, entry] : tab.structures_) {
-            if (!entry.has_content) {
+            if (entry.tree.empty()) {
                 continue;
             }
             if (ImGui::TreeNode(key.c_str())) {
-                for (const auto& child : entry.root.children) {
-                    render_structure_node(child);
+                for (uint32_t child = entry.tree.root().first_child; child != StructureTree::kNone;
+                     child = entry.tree.node(child).next_sibling) {
+                    render_structure_node(entry.tree, child);
                 }
                 ImGui::TreePop();
                 structures_rendered = true;
@@ -623,28 +1881,19 @@ void DebugVisualizer::render_tab_contents(const Tab& tab) const {
     }
 }
 
-void DebugVisualizer::render_scalar(const std::string& key, const ScalarValue& value) const {
-    std::visit(
-        Overload{
-            [&](int64_t v) {
-                ImGui::Text("%s: %lld", key.c_str(), static_cast<long long>(v));
-            },
-            [&](double v) {
-                ImGui::Text("%s: %.3f", key.c_str(), v);
-            },
-            [&](bool v) {
-                ImGui::Text("%s: %s", key.c_str(), v ? "true" : "false");
-            },
-            [&](const std::string& v) {
-                ImGui::Text("%s: %s", key.c_str(), v.c_str());
-            }},
-        value);
+void DebugVisualizer::render_scalar(const std::string& key, const ScalarEntry& entry) const {
+    if (entry.dirty) {
+        entry.text = key + ": " + ScalarToString(entry.value);
+        entry.dirty = false;
+    }
+    ImGui::TextUnformatted(entry.text.c_str(), entry.text.c_str() + entry.text.size());
 }
 
-void DebugVisualizer::render_graph(const std::string& key, const DebugVisualizer::Graph& graph) const {
-    const auto& samples = graph.samples();
-    if (samples.empty()) {
-        ImGui::Text("%s: <no samples>", key.c_str());
+void DebugVisualizer::render_graph(const std::string& key, const DebugVisualizer::Graph& graph,
+                                   GraphGeometry& geometry) const {
+    if (graph.empty()) {
+        // Keep the row height uniform for the clipper.
+        ImGui::PlotLines(key.c_str(), nullptr, 0, 0, "<no samples>", 0.0f, 1.0f, ImVec2(0.0f, kGraphHeight));
         return;
     }
 
@@ -653,45 +1902,322 @@ void DebugVisualizer::render_graph(const std::string& key, const DebugVisualizer
     float min_value = cfg.manual_min;
     float max_value = cfg.manual_max;
     if (cfg.auto_scale) {
-        auto [min_it, max_it] = std::minmax_element(samples.begin(), samples.end());
-        min_value = *min_it;
-        max_value = *max_it;
+        min_value = graph.min_sample();
+        max_value = graph.max_sample();
         if (min_value == max_value) {
             min_value -= 1.0f;
             max_value += 1.0f;
         }
     }
 
-    ImGui::PlotLines(
+    // Laid out like ImGui::PlotLines: the frame, then the key beside it.
+    const ImGuiStyle& style = ImGui::GetStyle();
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float width = std::max(ImGui::CalcItemWidth(), 1.0f);
+    const ImVec2 corner(origin.x + width, origin.y + kGraphHeight);
+    ImGui::Dummy(ImVec2(width, kGraphHeight));
+    const bool hovered = ImGui::IsItemHovered();
+    ImGui::SameLine(0.0f, style.ItemInnerSpacing.x);
+    ImGui::TextUnformatted(key.c_str(), key.c_str() + key.size());
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    draw->AddRectFilled(origin, corner, ImGui::GetColorU32(ImGuiCol_FrameBg), style.FrameRounding);
+    const float inner_width = std::max(width - style.FramePadding.x * 2.0f, 1.0f);
+    const float inner_height = std::max(kGraphHeight - style.FramePadding.y * 2.0f, 1.0f);
+
+    const size_t columns = static_cast<size_t>(inner_width);
+    const size_t level = graph.plot_level(columns);
+
+    // Most graphs receive samples far less often than frames are drawn.
+    // Until the samples, the scale, the plot size or the style move, the
+    // vertices built last time are copied back in at the current origin.
+    const ImU32 color = ImGui::GetColorU32(ImGuiCol_PlotLines);
+    const ImVec2 white = ImGui::GetFontTexUvWhitePixel();
+    const bool cached = geometry.graph == &graph && geometry.pushed == graph.pushed() &&
+                        geometry.size == graph.size() && geometry.level == level && geometry.width == inner_width &&
+                        geometry.height == inner_height && geometry.min_value == min_value &&
+                        geometry.max_value == max_value && geometry.color == color &&
+                        geometry.flags == static_cast<int>(draw->Flags) && geometry.white_u == white.x &&
+                        geometry.white_v == white.y;
+    const ImVec2 inner(origin.x + style.FramePadding.x, origin.y + style.FramePadding.y);
+    if (!cached) {
+        geometry.graph = &graph;
+        geometry.pushed = graph.pushed();
+        geometry.size = graph.size();
+        geometry.level = level;
+        geometry.width = inner_width;
+        geometry.height = inner_height;
+        geometry.min_value = min_value;
+        geometry.max_value = max_value;
+        geometry.color = color;
+        geometry.flags = static_cast<int>(draw->Flags);
+        geometry.white_u = white.x;
+        geometry.white_v = white.y;
+        geometry.vertices.clear();
+        geometry.indices.clear();
+
+        // Every (min, max) pair of an LOD level is drawn so spikes survive.
+        thread_local std::vector<float> values;
+        graph.plot_values(columns, values);
+        const float inv_scale = min_value == max_value ? 0.0f : 1.0f / (max_value - min_value);
+        const auto point = [&](float t, float sample) {
+            const float y = std::clamp((sample - min_value) * inv_scale, 0.0f, 1.0f);
+            return ImVec2(inner.x + t * inner_width, inner.y + (1.0f - y) * inner_height);
+        };
+
+        thread_local std::vector<ImVec2> points;
+        points.clear();
+        if (values.size() >= 2) {
+            const float step = 1.0f / static_cast<float>(values.size() - 1);
+            for (size_t i = 0; i < values.size(); ++i) {
+                points.push_back(point(static_cast<float>(i) * step, values[i]));
+            }
+        }
+
+        // Draw once through the draw list and keep what it generated.
+        const int first_vertex = draw->VtxBuffer.Size;
+        const int first_index = draw->IdxBuffer.Size;
+        if (points.size() >= 2) {
+            draw->AddPolyline(points.data(), static_cast<int>(points.size()), color, ImDrawFlags_None, 1.0f);
+        }
+        const int vertex_count = draw->VtxBuffer.Size - first_vertex;
+        // Indices count from the vertex offset of the command they landed in.
+        const unsigned int base = static_cast<unsigned int>(first_vertex) - draw->CmdBuffer.back().VtxOffset;
+        geometry.vertices.reserve(static_cast<size_t>(vertex_count));
+        for (int i = first_vertex; i < draw->VtxBuffer.Size; ++i) {
+            const ImDrawVert& vertex = draw->VtxBuffer[i];
+            geometry.vertices.push_back(
+                {vertex.pos.x - origin.x, vertex.pos.y - origin.y, vertex.uv.x, vertex.uv.y, vertex.col});
+        }
+        geometry.indices.reserve(static_cast<size_t>(draw->IdxBuffer.Size - first_index));
+        for (int i = first_index; i < draw->IdxBuffer.Size; ++i) {
+            geometry.indices.push_back(static_cast<uint32_t>(draw->IdxBuffer[i]) - base);
+        }
+    } else if (!geometry.vertices.empty()) {
+        const int vertex_count = static_cast<int>(geometry.vertices.size());
+        const int index_count = static_cast<int>(geometry.indices.size());
+        draw->PrimReserve(index_count, vertex_count);
+        // PrimReserve() may have opened a new command for the vertices.
+        const unsigned int base =
+            static_cast<unsigned int>(draw->VtxBuffer.Size - vertex_count) - draw->CmdBuffer.back().VtxOffset;
+        for (const GraphGeometry::Vertex& vertex : geometry.vertices) {
+            draw->PrimWriteVtx(ImVec2(origin.x + vertex.x, origin.y + vertex.y), ImVec2(vertex.u, vertex.v),
+                               vertex.color);
+        }
+        for (const uint32_t index : geometry.indices) {
+            draw->PrimWriteIdx(static_cast<ImDrawIdx>(base + index));
+        }
+    }
+
+    if (hovered) {
+        const float t = std::clamp((ImGui::GetMousePos().x - inner.x) / inner_width, 0.0f, 0.9999f);
+        const size_t index = static_cast<size_t>(t * static_cast<float>(graph.size()));
+        ImGui::SetTooltip("%zu: %8.4g", index, static_cast<double>(graph.sample(index)));
+    }
+}
+
+void DebugVisualizer::render_series(const std::string& key, const TimeSeries& series) const {
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float width = std::max(ImGui::CalcItemWidth(), 1.0f);
+    const ImVec2 corner(origin.x + width, origin.y + kGraphHeight);
+    ImGui::Dummy(ImVec2(width, kGraphHeight));
+    ImGui::SameLine(0.0f, ImGui::GetStyle().ItemInnerSpacing.x);
+    ImGui::TextUnformatted(key.c_str(), key.c_str() + key.size());
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    draw->AddRectFilled(origin, corner, ImGui::GetColorU32(ImGuiCol_FrameBg));
+    const ImVec2 text_origin(origin.x + ImGui::GetStyle().FramePadding.x, origin.y + ImGui::GetStyle().FramePadding.y);
+    if (series.empty()) {
+        draw->AddText(text_origin, ImGui::GetColorU32(ImGuiCol_Text), "<no samples>");
+        return;
+    }
+
+    const TimeSeriesConfig& cfg = series.config();
+    float min_value = cfg.manual_min;
+    float max_value = cfg.manual_max;
+    if (cfg.auto_scale) {
+        min_value = series.min_value();
+        max_value = series.max_value();
+    }
+    if (min_value == max_value) {
+        min_value -= 1.0f;
+        max_value += 1.0f;
+    }
+
+    // The x axis ends at the newest row and spans the time window (or the
+    // retained rows when there is none), so irregular rates plot to scale.
+    const double newest = series.latest_time();
+    double span = cfg.time_window > 0.0 ? cfg.time_window : newest - series.time(0);
+    if (span <= 0.0) {
+        span = 1.0;
+    }
+    const double left = newest - span;
+    const float x_scale = static_cast<float>(width / span);
+    const float y_scale = kGraphHeight / (max_value - min_value);
+
+    // Reused across frames; rows are folded into one (min, max) pair per
+    // pixel column so the vertex count follows the plot width.
+    thread_local std::vector<ImVec2> points;
+    draw->PushClipRect(origin, corner, true);
+    float legend_x = text_origin.x;
+    for (size_t column = 0; column < series.series_count(); ++column) {
+        const ImU32 color = kSeriesColors[column % (sizeof(kSeriesColors) / sizeof(kSeriesColors[0]))];
+        points.clear();
+        bool open = false;
+        int pixel = 0;
+        float low = 0.0f;
+        float high = 0.0f;
+        const auto flush = [&] {
+            const float x = origin.x + static_cast<float>(pixel);
+            points.emplace_back(x, corner.y - (high - min_value) * y_scale);
+            if (low != high) {
+                points.emplace_back(x, corner.y - (low - min_value) * y_scale);
+            }
+        };
+        for (size_t i = 0; i < series.size(); ++i) {
+            const float sample = series.value(column, i);
+            if (std::isnan(sample)) {
+                continue;
+            }
+            const int x = std::clamp(static_cast<int>(static_cast<float>(series.time(i) - left) * x_scale), 0,
+                                     static_cast<int>(width));
+            if (open && x == pixel) {
+                low = std::min(low, sample);
+                high = std::max(high, sample);
+                continue;
+            }
+            if (open) {
+                flush();
+            }
+            open = true;
+            pixel = x;
+            low = high = sample;
+        }
+        if (open) {
+            flush();
+        }
+        if (points.size() > 1) {
+            draw->AddPolyline(points.data(), static_cast<int>(points.size()), color, 0, 1.0f);
+        }
+
+        const std::string label = series.series_label(column);
+        draw->AddText(ImVec2(legend_x, text_origin.y), color, label.c_str(), label.c_str() + label.size());
+        legend_x += ImGui::CalcTextSize(label.c_str(), label.c_str() + label.size()).x + kLegendSpacing;
+    }
+    draw->PopClipRect();
+}
+
+void DebugVisualizer::render_histogram(const std::string& key, const QuantileSketch& sketch) const {
+    if (sketch.empty()) {
+        ImGui::PlotHistogram(key.c_str(), nullptr, 0, 0, "<no samples>", 0.0f, 1.0f, ImVec2(0.0f, kGraphHeight));
+        return;
+    }
+    // Bars are the log-spaced buckets between the smallest and largest
+    // positive values seen.
+    char overlay[128];
+    std::snprintf(overlay, sizeof(overlay), "p50 %.4g  p99 %.4g  p999 %.4g  max %.4g  (n=%llu)", sketch.quantile(0.5),
+                  sketch.quantile(0.99), sketch.quantile(0.999), sketch.max(),
+                  static_cast<unsigned long long>(sketch.count()));
+    ImGui::PlotHistogram(
         key.c_str(),
-        samples.data(),
-        static_cast<int>(samples.size()),
+        &HistogramBarGetter,
+        const_cast<QuantileSketch*>(&sketch),
+        static_cast<int>(sketch.counts().size()),
         0,
-        nullptr,
-        min_value,
-        max_value,
-        ImVec2(0.0f, 80.0f));
+        overlay,
+        0.0f,
+        FLT_MAX,
+        ImVec2(0.0f, kGraphHeight));
+}
+
+void DebugVisualizer::render_zone_timeline(const std::string& key, const ZoneTimeline& timeline) const {
+    const float row_height = ImGui::GetTextLineHeight() + 2.0f;
+    // Lanes stack top to bottom in first-seen order, one row per nesting
+    // level plus a label row.
+    thread_local std::vector<float> lane_tops;
+    lane_tops.assign(timeline.lane_count(), 0.0f);
+    float height = 0.0f;
+    for (size_t lane = 0; lane < timeline.lane_count(); ++lane) {
+        lane_tops[lane] = height + row_height;
+        height += row_height * static_cast<float>(timeline.lane_depth(static_cast<uint32_t>(lane)) + 1);
+    }
+    height = std::max(height, row_height);
+
+    ImGui::TextUnformatted(key.c_str(), key.c_str() + key.size());
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+    const ImVec2 corner(origin.x + width, origin.y + height);
+    ImGui::Dummy(ImVec2(width, height));
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    draw->AddRectFilled(origin, corner, ImGui::GetColorU32(ImGuiCol_FrameBg));
+    const ImU32 text_color = ImGui::GetColorU32(ImGuiCol_Text);
+    if (timeline.empty()) {
+        draw->AddText(ImVec2(origin.x + ImGui::GetStyle().FramePadding.x, origin.y), text_color, "<no zones>");
+        return;
+    }
+
+    // The right edge is the newest zone end; the span is the retention
+    // window.
+    const double span = timeline.window() > 0.0 ? timeline.window() : 1.0;
+    const double left = timeline.latest_time() - span;
+    const float x_scale = static_cast<float>(width / span);
+    const bool hovered = ImGui::IsMouseHoveringRect(origin, corner);
+    const ImVec2 mouse = ImGui::GetMousePos();
+    const ZoneTimeline::Zone* hovered_zone = nullptr;
+
+    draw->PushClipRect(origin, corner, true);
+    for (size_t lane = 0; lane < timeline.lane_count(); ++lane) {
+        const std::string& label = timeline.lane_label(static_cast<uint32_t>(lane));
+        draw->AddText(ImVec2(origin.x + ImGui::GetStyle().FramePadding.x, origin.y + lane_tops[lane] - row_height),
+                      text_color, label.c_str(), label.c_str() + label.size());
+    }
+    for (const ZoneTimeline::Zone& zone : timeline.zones()) {
+        if (zone.end < left) {
+            continue;
+        }
+        const float x0 = origin.x + static_cast<float>(zone.begin - left) * x_scale;
+        // At least one pixel wide so short zones stay visible.
+        const float x1 = std::max(origin.x + static_cast<float>(zone.end - left) * x_scale, x0 + 1.0f);
+        const float y0 = origin.y + lane_tops[zone.lane] + row_height * static_cast<float>(zone.depth);
+        const ImVec2 a(std::max(x0, origin.x), y0);
+        const ImVec2 b(x1, y0 + row_height - 1.0f);
+        draw->AddRectFilled(a, b, kSeriesColors[zone.name % (sizeof(kSeriesColors) / sizeof(kSeriesColors[0]))]);
+        const std::string& name = timeline.name(zone.name);
+        const ImVec2 text_size = ImGui::CalcTextSize(name.c_str(), name.c_str() + name.size());
+        if (b.x - a.x > text_size.x + 4.0f) {
+            draw->AddText(ImVec2(a.x + 2.0f, y0), IM_COL32(0, 0, 0, 255), name.c_str(), name.c_str() + name.size());
+        }
+        if (hovered && mouse.x >= a.x && mouse.x < b.x && mouse.y >= a.y && mouse.y < b.y) {
+            hovered_zone = &zone;
+        }
+    }
+    draw->PopClipRect();
+
+    if (hovered_zone) {
+        ImGui::SetTooltip("%s  %s\n%.3f ms", timeline.lane_label(hovered_zone->lane).c_str(),
+                          timeline.name(hovered_zone->name).c_str(),
+                          (hovered_zone->end - hovered_zone->begin) * 1000.0);
+    }
 }
 
-void DebugVisualizer::render_structure_node(const StructureNode& node) const {
-    if (!node.children.empty()) {
+void DebugVisualizer::render_structure_node(const StructureTree& tree, uint32_t index) const {
+    const StructureTree::Node& node = tree.node(index);
+    if (node.first_child != StructureTree::kNone) {
         if (ImGui::TreeNode(node.label.c_str())) {
-            if (node.value.has_value()) {
-                ImGui::Text("%s", ScalarToString(*node.value).c_str());
-            }
-            for (const auto& child : node.children) {
-                render_structure_node(child);
+            for (uint32_t child = node.first_child; child != StructureTree::kNone; child = tree.node(child).next_sibling) {
+                render_structure_node(tree, child);
             }
             ImGui::TreePop();
         }
         return;
     }
 
-    if (node.value.has_value()) {
-        ImGui::Text("%s: %s", node.label.c_str(), ScalarToString(*node.value).c_str());
-    } else {
-        ImGui::Text("%s", node.label.c_str());
+    if (node.dirty) {
+        node.text = node.value.has_value() ? node.label + ": " + ScalarToString(*node.value) : node.label;
+        node.dirty = false;
     }
+    ImGui::TextUnformatted(node.text.c_str(), node.text.c_str() + node.text.size());
 }
 
 void DebugVisualizer::clear() {
@@ -743,6 +2269,19 @@ void DebugVisualizer::add_graph_samples(const std::string& key,
     default_tab().add_graph_samples(key, samples, config);
 }
 
+void DebugVisualizer::add_graph_samples(const std::string& key,
+                                         std::vector<float>&& samples,
+                                         const GraphConfig& config) {
+    default_tab().add_graph_samples(key, std::move(samples), config);
+}
+
+void DebugVisualizer::add_graph_samples(const std::string& key,
+                                         const float* samples,
+                                         size_t count,
+                                         const GraphConfig& config) {
+    default_tab().add_graph_samples(key, samples, count, config);
+}
+
 void DebugVisualizer::update_structure(const std::string& key,
                                        const std::function<void(StructureBuilder&)>& builder) {
     default_tab().update_structure(key, builder);
@@ -779,18 +2318,16 @@ DebugVisualizer::Tab& DebugVisualizer::ensure_tab(const std::string& id, const s
 
     auto tab = std::make_unique<Tab>(id, title.empty() ? id : title);
     Tab& ref = *tab;
+    // Until the next render decides, a new tab in a hidden window is hidden.
+    ref.shown_ = visible_ || !defer_hidden_structures_;
+    tab_index_.emplace(id, &ref);
     tabs_.push_back(std::move(tab));
     return ref;
 }
 
 const DebugVisualizer::Tab* DebugVisualizer::find_tab_internal(const std::string& id) const {
-    auto it = std::find_if(tabs_.begin(), tabs_.end(), [&](const std::unique_ptr<Tab>& tab) {
-        return tab->id() == id;
-    });
-    if (it == tabs_.end()) {
-        return nullptr;
-    }
-    return it->get();
+    auto it = tab_index_.find(id);
+    return it == tab_index_.end() ? nullptr : it->second;
 }
 
 }  // namespace dbgvis
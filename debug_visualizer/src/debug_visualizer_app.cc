@@ -20,38 +20,56 @@
  */
 
 #include "debug_visualizer/debug_visualizer.h"
+#include "debug_visualizer/recording.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <utility>
 #include <string>
 #include <vector>
 
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
-
 #include <imgui/imgui.h>
-#ifndef IMGUI_IMPL_OPENGL_LOADER_GLEW
-#define IMGUI_IMPL_OPENGL_LOADER_GLEW
-#endif
-#include <imgui/imgui_impl_glfw.h>
-#include <imgui/imgui_impl_opengl3.h>
+
+#include "debug_visualizer/src/app_backend.h"
+#include "debug_visualizer/src/shm_transport.h"
+#include "debug_visualizer/src/stream_transport.h"
 
 namespace dbgvis {
 namespace {
-void GlfwErrorCallback(int error, const char* description) {
-    std::fprintf(stderr, "GLFW Error (%d): %s\n", error, description);
+// Frames drawn after input so hover and click state settles.
+constexpr int kInputSettleFrames = 3;
+// Longest single wait, so min_refresh_hz = 0 still rechecks ShouldClose().
+constexpr double kMaxWaitSeconds = 1.0;
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
-void GlfwKeyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/) {
-    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, GLFW_TRUE);
-    }
+AppBackendFactory& WindowedBackendFactory() {
+    static AppBackendFactory factory = nullptr;
+    return factory;
 }
 }  // namespace
 
+bool RegisterWindowedBackend(AppBackendFactory factory) {
+    WindowedBackendFactory() = factory;
+    return true;
+}
+
+std::unique_ptr<AppBackend> CreateWindowedBackend() {
+    AppBackendFactory factory = WindowedBackendFactory();
+    return factory ? factory() : nullptr;
+}
+
 struct DebugVisualizerApp::Impl {
     explicit Impl(DebugVisualizerAppOptions opts) : options(std::move(opts)) {
         visualizer.set_window_title(options.window_title);
+        visualizer.set_defer_hidden_structures(options.defer_hidden_structures);
     }
 
     ~Impl() {
@@ -60,105 +78,216 @@ struct DebugVisualizerApp::Impl {
 
     bool Initialize();
     void Shutdown();
+    void AttachWindow();
     void ApplyWindowTitle();
+    void WaitForFrame();
+    void Wake();
+    void AdvanceReplay(float delta_time, bool draw_controls);
 
     DebugVisualizerAppOptions options;
-    GLFWwindow* window = nullptr;
-    bool glfw_initialized = false;
-    bool imgui_initialized = false;
+    std::unique_ptr<AppBackend> backend;
+    // The backend as seen by other threads: set only while it is initialized.
+    std::mutex wake_mutex;
+    AppBackend* wake_target = nullptr;
+    std::atomic<bool> redraw_requested{true};
+    std::atomic<bool> attach_requested{false};
+    int settle_frames = 0;
     double last_time = 0.0;
+    std::unique_ptr<RecordingReader> replay;
+    bool replay_playing = true;
+    float replay_speed = 1.0f;
+    double replay_clock = 0.0;
+    std::unique_ptr<stream::Server> server;
+    std::unique_ptr<shm::Watcher> watcher;
     DebugVisualizer visualizer;
     std::string applied_window_title;
+    AppFrameStats frame_stats;
 };
 
 bool DebugVisualizerApp::Impl::Initialize() {
-    glfwSetErrorCallback(GlfwErrorCallback);
-    if (!glfwInit()) {
-        std::fprintf(stderr, "Failed to initialize GLFW\n");
-        return false;
+    if (options.headless || options.defer_window) {
+        backend = CreateHeadlessBackend();
+    } else {
+        backend = CreateWindowedBackend();
+        if (!backend) {
+            std::fprintf(stderr,
+                         "No windowed backend linked; depend on //debug_visualizer:debug_visualizer "
+                         "or set DebugVisualizerAppOptions::headless\n");
+            return false;
+        }
     }
-    glfw_initialized = true;
-
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, options.gl_context_major_version);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, options.gl_context_minor_version);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
 
-    window = glfwCreateWindow(options.width, options.height, options.window_title.c_str(), nullptr, nullptr);
-    if (!window) {
-        std::fprintf(stderr, "Failed to create GLFW window\n");
-        Shutdown();
-        return false;
+    if (!options.replay_path.empty()) {
+        replay = RecordingReader::open(options.replay_path);
+        if (!replay) {
+            std::fprintf(stderr, "Failed to open recording %s\n", options.replay_path.c_str());
+            return false;
+        }
+        replay_clock = 0.0;
+        if (replay->frame_count() > 0) {
+            replay->seek(0, visualizer.window_tile(replay->tile_id()));
+        }
     }
 
-    glfwSetKeyCallback(window, GlfwKeyCallback);
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(options.vsync ? 1 : 0);
+    const std::string& listen = options.listen_address;
+    if (listen.rfind(shm::kScheme, 0) == 0) {
+        watcher = std::make_unique<shm::Watcher>();
+        if (!watcher->listen(listen.substr(sizeof(shm::kScheme) - 1))) {
+            std::fprintf(stderr, "Failed to watch shared memory for %s\n", listen.c_str());
+            return false;
+        }
+    } else if (!listen.empty()) {
+        server = std::make_unique<stream::Server>();
+        if (!server->listen(listen)) {
+            std::fprintf(stderr, "Failed to listen on %s\n", options.listen_address.c_str());
+            return false;
+        }
+    }
 
-    glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-        std::fprintf(stderr, "Failed to initialize GLEW\n");
+    if (!backend->Initialize(options)) {
         Shutdown();
         return false;
     }
 
-    glGetError();  // Clear spurious error from GLEW initialization.
-
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO();
-    if (options.enable_keyboard_navigation) {
-        io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
-    }
-    if (options.enable_docking) {
-#ifdef ImGuiConfigFlags_DockingEnable
-        io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
-#endif
-    }
-
-    ImGui::StyleColorsDark();
-
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init(options.glsl_version.c_str());
-    imgui_initialized = true;
-
-    last_time = glfwGetTime();
+    last_time = backend->Time();
     ApplyWindowTitle();
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake_target = backend.get();
+    }
     return true;
 }
 
 void DebugVisualizerApp::Impl::Shutdown() {
-    if (imgui_initialized) {
-        ImGui_ImplOpenGL3_Shutdown();
-        ImGui_ImplGlfw_Shutdown();
-        ImGui::DestroyContext();
-        imgui_initialized = false;
+    replay.reset();
+    server.reset();
+    watcher.reset();
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake_target = nullptr;
+    }
+    if (backend) {
+        backend->Shutdown();
+        backend.reset();
     }
+    applied_window_title.clear();
+}
 
-    if (window) {
-        glfwDestroyWindow(window);
-        window = nullptr;
+// Swaps the headless backend for a window between two frames. Everything
+// but the backend lives in Impl, so tiles, replay and listeners carry over.
+void DebugVisualizerApp::Impl::AttachWindow() {
+    std::unique_ptr<AppBackend> window = CreateWindowedBackend();
+    if (!window) {
+        std::fprintf(stderr, "No windowed backend linked; depend on //debug_visualizer:debug_visualizer\n");
+        return;
+    }
+    if (!window->Initialize(options)) {
+        std::fprintf(stderr, "Failed to open the window; staying headless\n");
+        return;
     }
 
-    if (glfw_initialized) {
-        glfwTerminate();
-        glfw_initialized = false;
+    std::unique_ptr<AppBackend> previous;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        previous = std::move(backend);
+        backend = std::move(window);
+        wake_target = backend.get();
     }
+    previous->Shutdown();
+    last_time = backend->Time();
+    applied_window_title.clear();
+    ApplyWindowTitle();
+    redraw_requested.store(true, std::memory_order_release);
 }
 
 void DebugVisualizerApp::Impl::ApplyWindowTitle() {
-    if (!window) {
+    if (!backend) {
         return;
     }
     const std::string& desired_title = visualizer.window_title().empty() ? options.window_title : visualizer.window_title();
     if (desired_title != applied_window_title) {
-        glfwSetWindowTitle(window, desired_title.c_str());
+        backend->SetTitle(desired_title);
         applied_window_title = desired_title;
     }
 }
 
+void DebugVisualizerApp::Impl::WaitForFrame() {
+    const double min_interval = options.max_fps > 0.0f ? 1.0 / options.max_fps : 0.0;
+    const double max_interval =
+        options.min_refresh_hz > 0.0f ? 1.0 / options.min_refresh_hz : std::numeric_limits<double>::infinity();
+
+    while (!backend->ShouldClose()) {
+        const double since = backend->Time() - last_time;
+        if (since >= max_interval) {
+            return;
+        }
+        if (since >= min_interval) {
+            if (settle_frames > 0) {
+                --settle_frames;
+                return;
+            }
+            if (redraw_requested.exchange(false, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+
+        const double timeout = std::min(since < min_interval ? min_interval - since : max_interval - since,
+                                        kMaxWaitSeconds);
+        const double before = backend->Time();
+        backend->WaitEvents(timeout);
+        // An early return without a redraw request means an input event.
+        if (backend->Time() - before < timeout && !redraw_requested.load(std::memory_order_acquire)) {
+            settle_frames = kInputSettleFrames;
+        }
+    }
+}
+
+void DebugVisualizerApp::Impl::AdvanceReplay(float delta_time, bool draw_controls) {
+    const uint64_t frames = replay->frame_count();
+    if (frames == 0) {
+        return;
+    }
+    DebugVisualizer& tile = visualizer.window_tile(replay->tile_id());
+
+    if (draw_controls) {
+        ImGui::Begin("Replay");
+        if (ImGui::Button(replay_playing ? "Pause" : "Play")) {
+            replay_playing = !replay_playing;
+        }
+        ImGui::SameLine();
+        ImGui::Text("%.2f / %.2f s", replay->time(), replay->duration());
+        uint64_t frame = replay->frame();
+        const uint64_t first = 0;
+        const uint64_t last = frames - 1;
+        if (ImGui::SliderScalar("Frame", ImGuiDataType_U64, &frame, &first, &last) && replay->seek(frame, tile)) {
+            replay_clock = replay->time();
+        }
+        ImGui::SliderFloat("Speed", &replay_speed, 0.1f, 16.0f, "%.1fx");
+        ImGui::End();
+    }
+
+    if (!replay_playing) {
+        return;
+    }
+    replay_clock += static_cast<double>(delta_time) * replay_speed;
+    while (replay->frame() + 1 < frames && replay->time() < replay_clock) {
+        if (!replay->seek(replay->frame() + 1, tile)) {
+            replay_playing = false;
+            break;
+        }
+    }
+    if (replay->frame() + 1 >= frames) {
+        replay_playing = false;
+    }
+}
+
+void DebugVisualizerApp::Impl::Wake() {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    if (wake_target) {
+        wake_target->Wake();
+    }
+}
+
 DebugVisualizerApp::TileCollection::TileCollection(DebugVisualizerApp* owner) : owner_(owner) {}
 
 DebugVisualizer& DebugVisualizerApp::TileCollection::operator[](const std::string& id) {
@@ -246,42 +375,80 @@ int DebugVisualizerApp::run(const UpdateCallback& callback) {
     }
 
     int exit_code = 0;
-    while (!glfwWindowShouldClose(impl_->window)) {
-        glfwPollEvents();
+    while (!impl_->backend->ShouldClose()) {
+        if (impl_->attach_requested.exchange(false, std::memory_order_acq_rel) && !impl_->options.headless &&
+            !impl_->backend->Renders()) {
+            impl_->AttachWindow();
+        }
 
-        double current_time = glfwGetTime();
+        AppBackend& backend = *impl_->backend;
+        const bool render_on_change = impl_->options.render_on_change && backend.Renders();
+        if (render_on_change) {
+            impl_->WaitForFrame();
+            if (backend.ShouldClose()) {
+                break;
+            }
+        } else {
+            backend.PollEvents();
+        }
+
+        double current_time = backend.Time();
         float delta_time = static_cast<float>(current_time - impl_->last_time);
         if (delta_time <= 0.0f) {
             delta_time = 1.0f / 60.0f;
         }
         impl_->last_time = current_time;
 
-        ImGuiIO& io = ImGui::GetIO();
-        io.DeltaTime = delta_time;
+        // Headless runs keep the same update cadence but never build an ImGui
+        // frame, so callbacks must not issue ImGui calls there.
+        const bool renders = backend.Renders();
+        if (renders) {
+            ImGuiIO& io = ImGui::GetIO();
+            io.DeltaTime = delta_time;
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+            backend.NewFrame();
+            ImGui::NewFrame();
+        }
 
+        using Clock = std::chrono::steady_clock;
+        AppFrameStats& stats = impl_->frame_stats;
+        auto stage = Clock::now();
         if (callback) {
             callback(*this, static_cast<float>(current_time), delta_time);
         }
+        stats.callback_ms = MillisecondsSince(stage);
+        ++stats.frames;
+
+        if (impl_->replay) {
+            impl_->AdvanceReplay(delta_time, renders);
+            if (impl_->replay_playing) {
+                request_redraw();
+            }
+        }
+
+        if ((impl_->server && impl_->server->poll(impl_->visualizer)) ||
+            (impl_->watcher && impl_->watcher->poll(impl_->visualizer))) {
+            request_redraw();
+        }
+
+        if (!renders) {
+            impl_->visualizer.skip_render();
+            continue;
+        }
 
         impl_->ApplyWindowTitle();
 
+        stage = Clock::now();
         impl_->visualizer.render();
+        stats.render_ms = MillisecondsSince(stage);
 
+        stage = Clock::now();
         ImGui::Render();
-        int display_w = 0;
-        int display_h = 0;
-        glfwGetFramebufferSize(impl_->window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        stats.imgui_render_ms = MillisecondsSince(stage);
 
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        glfwSwapBuffers(impl_->window);
+        stage = Clock::now();
+        backend.Present(ImGui::GetDrawData());
+        stats.present_ms = MillisecondsSince(stage);
     }
 
     impl_->Shutdown();
@@ -301,16 +468,35 @@ const DebugVisualizer* DebugVisualizerApp::findTile(const std::string& id) const
 }
 
 void DebugVisualizerApp::request_close() {
-    if (impl_ && impl_->window) {
-        glfwSetWindowShouldClose(impl_->window, GLFW_TRUE);
+    if (impl_ && impl_->backend) {
+        impl_->backend->RequestClose();
+        impl_->Wake();
     }
 }
 
+void DebugVisualizerApp::request_redraw() {
+    if (impl_ && !impl_->redraw_requested.exchange(true, std::memory_order_acq_rel)) {
+        impl_->Wake();
+    }
+}
+
+void DebugVisualizerApp::attach_window() {
+    if (impl_) {
+        impl_->attach_requested.store(true, std::memory_order_release);
+        impl_->Wake();
+    }
+}
+
+const AppFrameStats& DebugVisualizerApp::frame_stats() const {
+    static const AppFrameStats kEmpty;
+    return impl_ ? impl_->frame_stats : kEmpty;
+}
+
 bool DebugVisualizerApp::is_running() const {
-    if (!impl_ || !impl_->window) {
+    if (!impl_ || !impl_->backend) {
         return false;
     }
-    return glfwWindowShouldClose(impl_->window) == GLFW_FALSE;
+    return !impl_->backend->ShouldClose();
 }
 
 DebugVisualizer& DebugVisualizerApp::ensure_tile(const std::string& id, const std::string& title) {
@@ -21,58 +21,1573 @@
 
 #include "debug_visualizer/debug_visualizer.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include <unistd.h>
+
+#include "debug_visualizer/src/recording_format.h"
+#include "debug_visualizer/src/shm_transport.h"
+#include "debug_visualizer/src/stream_transport.h"
+
 namespace dbgvis {
 namespace {
 using UpdateFn = std::function<void(DebugVisualizerApp&)>;
 
+constexpr char kInternalsTile[] = "dbgvis internals";
+constexpr char kProfilerTab[] = "Profiler";
+constexpr char kZoneTimelineKey[] = "Zones";
+// A thread posts its zones once this many have ended, or once the oldest
+// buffered one is this old; past that age the service thread takes them.
+constexpr size_t kZoneBatchSize = 256;
+constexpr int64_t kZoneBatchNs = 10'000'000;
+constexpr auto kZoneStatsInterval = std::chrono::milliseconds(100);
+// Per-thread histogram sketches are posted about this often, by the
+// recording thread or, once it goes quiet, by the service thread.
+constexpr int64_t kHistogramPostNs = 50'000'000;
+// Shorter runs of tab-local updates are applied on the service thread
+// alone; handing them to the flush workers costs more than it saves.
+constexpr size_t kParallelApplyMin = 512;
+
+enum class UpdateOp : uint8_t {
+    kValue,
+    kGraphSample,
+    kKeyedValue,
+    kKeyedGraphSample,
+    kGraphSamples,
+    kSeriesConfig,
+    kSeriesSample,
+    kZones,
+    kHistogram,
+    kStructure,
+    kClearTab,
+    kCustom,
+};
+
+struct ZoneEvent {
+    uint32_t site;
+    uint32_t depth;
+    int64_t begin_ns;
+    int64_t end_ns;
+};
+
+// Zones that ended on one producer thread, in end order.
+struct ZoneBatch {
+    uint32_t thread = 0;
+    std::vector<ZoneEvent> events;
+};
+
+// The parts of the rarer records that do not fit inline.
+struct UpdatePayload {
+    // kGraphSamples, and kGraphSample when its config could not be interned.
+    GraphConfig config;
+    std::vector<float> samples;
+    // kSeriesSample rows carry their values in `samples`, stamped on the
+    // producer thread so irregular rates keep their spacing.
+    double time = 0.0;
+    std::shared_ptr<const TimeSeriesConfig> series_config;
+    std::shared_ptr<const ZoneBatch> zones;
+    // kHistogram: values recorded on one thread since its last post.
+    std::shared_ptr<const QuantileSketch> histogram;
+    // kStructure and kCustom.
+    UpdateFn custom;
+};
+
+// GraphConfig IDs; see InternGraphConfig().
+constexpr uint16_t kDefaultGraphConfig = 0;
+constexpr uint16_t kUninternedGraphConfig = UINT16_MAX;
+
+// One queued update. Scalars and graph samples are carried inline against
+// interned tab/key IDs (or, for the keyed ops, a registered Key in `key`),
+// with a graph's config as an interned ID; every other op keeps its data in
+// `payload`. kStructure records also fill in tab/key so they can be
+// coalesced.
+struct UpdateRecord {
+    UpdateOp op = UpdateOp::kCustom;
+    uint16_t config = kDefaultGraphConfig;
+    uint32_t tab = 0;
+    uint32_t key = 0;
+    float sample = 0.0f;
+    ScalarValue value;
+    std::unique_ptr<UpdatePayload> payload;
+
+    UpdatePayload& extra() {
+        if (!payload) {
+            payload = std::make_unique<UpdatePayload>();
+        }
+        return *payload;
+    }
+};
+// Scalar and sample records fill one cache line (with a 32-byte string).
+static_assert(sizeof(UpdateRecord) <= 64 || sizeof(std::string) > 32, "UpdateRecord outgrew a cache line");
+
+double SteadySeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t SteadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// clear_tab() and custom records order the updates around them and never
+// count against, or get dropped by, a queue bound.
+bool IsBarrier(UpdateOp op) {
+    return op == UpdateOp::kClearTab || op == UpdateOp::kCustom;
+}
+
+bool IsCoalescable(UpdateOp op) {
+    return op == UpdateOp::kValue || op == UpdateOp::kKeyedValue || op == UpdateOp::kStructure;
+}
+
+struct CoalesceKey {
+    UpdateOp op;
+    uint32_t tab;
+    uint32_t key;
+
+    bool operator==(const CoalesceKey& other) const {
+        return op == other.op && tab == other.tab && key == other.key;
+    }
+};
+
+// Defined with the key table below. A Key handle's value shares the slot of
+// its tab/key names, so mixing value(key, ...) and value(tab, key, ...) still
+// keeps the last write.
+CoalesceKey CoalesceKeyOf(const UpdateRecord& update);
+
+struct CoalesceKeyHash {
+    size_t operator()(const CoalesceKey& k) const {
+        const uint64_t packed = (static_cast<uint64_t>(k.tab) << 32) | k.key;
+        return std::hash<uint64_t>{}(packed * 31 + static_cast<uint64_t>(k.op));
+    }
+};
+
+// Ordered, optionally coalescing list of pending records. With coalescing, a
+// scalar or structure update for a key that is already pending overwrites
+// that record in place (last write wins), so memory is bounded by the number
+// of distinct keys. Custom records act as barriers: later updates are queued
+// behind them, as are clear_tab() records, so clear_tab() followed by
+// value() keeps the new value.
+// Live records are records_[head_, size); drop_oldest() only advances head_
+// (past barriers, which it keeps) and the dead prefix is compacted away once
+// it outgrows the live part.
+class UpdateQueue {
+public:
+    void push(UpdateRecord update, bool coalesce) {
+        if (coalesce && IsCoalescable(update.op)) {
+            auto [it, inserted] = index_.try_emplace(CoalesceKeyOf(update), records_.size());
+            if (!inserted) {
+                records_[it->second] = std::move(update);
+                return;
+            }
+        } else if (IsBarrier(update.op)) {
+            index_.clear();
+            ++barriers_;
+        }
+        records_.emplace_back(std::move(update));
+    }
+
+    // True when push() would overwrite a pending record instead of growing.
+    bool would_coalesce(const UpdateRecord& update, bool coalesce) const {
+        return coalesce && IsCoalescable(update.op) &&
+               index_.find(CoalesceKeyOf(update)) != index_.end();
+    }
+
+    size_t size() const {
+        return records_.size() - head_;
+    }
+
+    // Records a bound applies to: all but the barriers.
+    size_t bounded_size() const {
+        return size() - barriers_;
+    }
+
+    size_t reserved_bytes() const {
+        return records_.capacity() * sizeof(UpdateRecord);
+    }
+
+    // Drops the oldest record that is not a barrier. Barriers ahead of it
+    // move up one slot; none of them are in the index.
+    void drop_oldest() {
+        size_t victim = head_;
+        while (victim < records_.size() && IsBarrier(records_[victim].op)) {
+            ++victim;
+        }
+        if (victim == records_.size()) {
+            return;
+        }
+        UpdateRecord& oldest = records_[victim];
+        if (IsCoalescable(oldest.op)) {
+            auto it = index_.find(CoalesceKeyOf(oldest));
+            if (it != index_.end() && it->second == victim) {
+                index_.erase(it);
+            }
+        }
+        using difference_type = std::vector<UpdateRecord>::difference_type;
+        std::move_backward(records_.begin() + static_cast<difference_type>(head_),
+                           records_.begin() + static_cast<difference_type>(victim),
+                           records_.begin() + static_cast<difference_type>(victim + 1));
+        records_[head_] = UpdateRecord{};
+        ++head_;
+        if (head_ * 2 >= records_.size()) {
+            compact();
+        }
+    }
+
+    // Moves every pending record to the end of `out`.
+    void take(std::vector<UpdateRecord>& out) {
+        compact();
+        if (out.empty()) {
+            out.swap(records_);
+        } else {
+            for (auto& record : records_) {
+                out.emplace_back(std::move(record));
+            }
+        }
+        records_.clear();
+        index_.clear();
+        barriers_ = 0;
+    }
+
+    void clear() {
+        records_.clear();
+        index_.clear();
+        head_ = 0;
+        barriers_ = 0;
+    }
+
+private:
+    void compact() {
+        if (head_ == 0) {
+            return;
+        }
+        using difference_type = std::vector<UpdateRecord>::difference_type;
+        records_.erase(records_.begin(), records_.begin() + static_cast<difference_type>(head_));
+        for (auto& entry : index_) {
+            entry.second -= head_;
+        }
+        head_ = 0;
+    }
+
+    std::vector<UpdateRecord> records_;
+    std::unordered_map<CoalesceKey, size_t, CoalesceKeyHash> index_;
+    size_t head_ = 0;
+    size_t barriers_ = 0;
+};
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Single-producer/single-consumer ring. The owning producer thread is the only
+// caller of try_push(); the service thread is the only caller of drain().
+class ProducerRing {
+public:
+    explicit ProducerRing(size_t capacity)
+            : slots_(RoundUpToPowerOfTwo(capacity == 0 ? 1 : capacity)), mask_(slots_.size() - 1) {}
+
+    bool try_push(UpdateRecord& update) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= slots_.size()) {
+            return false;
+        }
+        slots_[tail & mask_] = std::move(update);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    void drain(std::vector<UpdateRecord>& out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            UpdateRecord& slot = slots_[head & mask_];
+            out.emplace_back(std::move(slot));
+        }
+        head_.store(head, std::memory_order_release);
+    }
+
+    size_t reserved_bytes() const {
+        return slots_.size() * sizeof(UpdateRecord);
+    }
+
+private:
+    std::vector<UpdateRecord> slots_;
+    const size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// Per-thread queue used in ProducerQueueMode::kPerThreadRing. When the ring is
+// full the producer spills into `overflow`, guarded by a mutex that only this
+// producer and the service thread ever take. While spilled, every update goes
+// to `overflow` so per-thread ordering is preserved. Coalescable updates always
+// go to `overflow` when coalescing is enabled, since ring slots cannot be
+// rewritten once published.
+struct ProducerQueue {
+    explicit ProducerQueue(size_t capacity) : ring(capacity) {}
+
+    ProducerRing ring;
+    std::mutex overflow_mutex;
+    std::condition_variable overflow_space;
+    UpdateQueue overflow;
+    std::atomic<bool> overflowing{false};
+    std::atomic<bool> retired{false};
+};
+
+// Guards per-thread data its owner touches on every call and the service
+// thread only now and then. Held for a few instructions at a time; taking it
+// uncontended is one exchange, half what std::mutex costs.
+class SpinLock {
+public:
+    void lock() {
+        while (flag_.exchange(true, std::memory_order_acquire)) {
+            while (flag_.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void unlock() {
+        flag_.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> flag_{false};
+};
+
+class ZoneBuffer;
+class HistogramBuffer;
+
+// Tab and key names are interned once into small integer IDs so queued
+// records stay flat. Producers consult a thread-local cache first and only
+// take `mutex` the first time they see a name.
+struct NameTable {
+    std::mutex mutex;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> names;
+};
+
+// Non-default GraphConfigs passed to graph_sample(), interned so the record
+// carries a 16-bit ID; ID 0 is GraphConfig{}.
+struct ConfigTable {
+    std::mutex mutex;
+    std::vector<GraphConfig> configs{GraphConfig{}};
+};
+
+struct KeyInfo {
+    uint32_t tab = 0;
+    uint32_t key = 0;
+    bool is_graph = false;
+    GraphConfig config;
+};
+
+// Registered Keys, indexed by Key::id. Registration is the only writer.
+struct KeyTable {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, uint32_t> value_ids;
+    std::unordered_map<uint64_t, uint32_t> graph_ids;
+    std::vector<KeyInfo> keys;
+};
+
+// Service-thread view of a registered Key: the resolved tab and slot, valid
+// while the tab's generation matches.
+struct ResolvedKey {
+    KeyInfo info;
+    DebugVisualizer::Tab* tab = nullptr;
+    uint64_t generation = 0;
+    DebugVisualizer::ScalarEntry* scalar = nullptr;
+    DebugVisualizer::Graph* graph = nullptr;
+};
+
+// Where a tab-local update lands, resolved on the service thread so that
+// applying it touches nothing outside `tab`.
+struct ApplyTarget {
+    DebugVisualizer::Tab* tab = nullptr;
+    const std::string* key = nullptr;
+    DebugVisualizer::ScalarEntry* scalar = nullptr;
+    DebugVisualizer::Graph* graph = nullptr;
+    const GraphConfig* config = nullptr;
+};
+
+// Worker threads FlushUpdates() hands tabs to. run() works on the calling
+// thread too and returns once every item is done.
+class FlushPool {
+public:
+    ~FlushPool() {
+        stop();
+    }
+
+    void start(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back([this] {
+                Work();
+            });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+        threads_.clear();
+        stopping_ = false;
+    }
+
+    size_t size() const {
+        return threads_.size();
+    }
+
+    void run(size_t count, const std::function<void(size_t)>& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            count_ = count;
+            next_.store(0, std::memory_order_relaxed);
+            active_ = threads_.size();
+            ++round_;
+        }
+        wake_.notify_all();
+        Drain(job, count);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] {
+            return active_ == 0;
+        });
+        job_ = nullptr;
+    }
+
+private:
+    void Drain(const std::function<void(size_t)>& job, size_t count) {
+        for (size_t i = next_.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = next_.fetch_add(1, std::memory_order_relaxed)) {
+            job(i);
+        }
+    }
+
+    void Work() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] {
+                return stopping_ || round_ != seen;
+            });
+            if (stopping_) {
+                return;
+            }
+            seen = round_;
+            const std::function<void(size_t)>& job = *job_;
+            const size_t count = count_;
+            lock.unlock();
+            Drain(job, count);
+            lock.lock();
+            if (--active_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::vector<std::thread> threads_;
+    const std::function<void(size_t)>* job_ = nullptr;
+    size_t count_ = 0;
+    std::atomic<size_t> next_{0};
+    size_t active_ = 0;
+    uint64_t round_ = 0;
+    bool stopping_ = false;
+};
+
+// FlushUpdates() scratch for splitting a run of updates by tab; kept
+// between flushes so steady-state flushing does not allocate.
+struct TabGroups {
+    std::vector<ApplyTarget> targets;
+    std::unordered_map<const DebugVisualizer::Tab*, size_t> index;
+    std::vector<std::vector<uint32_t>> groups;
+    size_t used = 0;
+};
+
+// Service-thread bookkeeping behind GetVisualizerStats().
+struct ServiceCounters {
+    using Clock = std::chrono::steady_clock;
+
+    size_t flush_depth = 0;
+    size_t peak_depth = 0;
+    size_t producer_bytes = 0;
+    double flush_ms = 0.0;
+    uint64_t applied = 0;
+    uint64_t rate_base = 0;
+    double rate = 0.0;
+    Clock::time_point rate_start = Clock::now();
+    Clock::time_point next_tab_refresh;
+};
+
+// Zone durations gathered since the last emit, per zone site; the service
+// graphs their mean and p99 every kZoneStatsInterval.
+struct ZoneStats {
+    uint32_t mean_key = 0;
+    uint32_t p99_key = 0;
+    std::vector<float> durations_ms;
+};
+
+struct ZoneAggregator {
+    std::unordered_map<uint32_t, ZoneStats> sites;
+    std::chrono::steady_clock::time_point next_emit;
+};
+
+// A Counter or Gauge the service polls each frame; dropped once the
+// registry holds the last reference.
+struct MetricEntry {
+    Key key;
+    std::shared_ptr<const Counter::Shard[]> counter;
+    std::shared_ptr<const Gauge::Cell> gauge;
+    ScalarValue last;
+    bool published = false;
+};
+
+// A tab with a live TabReader. `fresh` until its first snapshot, which
+// then has no predecessor to share graphs with.
+struct SnapshotEntry {
+    uint32_t tab = 0;
+    std::shared_ptr<TabReader::Slot> slot;
+    bool fresh = true;
+};
+
+// Tabs changed by the current flush, tracked only while a reader exists.
+// Consecutive updates mostly hit the same tab, so `last` skips the set.
+struct TouchedTabs {
+    bool active = false;
+    bool all = false;
+    const DebugVisualizer::Tab* last = nullptr;
+    std::unordered_set<const DebugVisualizer::Tab*> tabs;
+};
+
 struct ServiceState {
     std::mutex mutex;
-    std::vector<UpdateFn> pending_updates;
+    UpdateQueue pending_updates;
+    std::condition_variable pending_space;
+    std::vector<UpdateRecord> flush_buffer;
+    NameTable name_table;
+    // A deque so names handed out by NameOf() stay put as it grows.
+    std::deque<std::string> resolved_names;
+    ConfigTable config_table;
+    std::deque<GraphConfig> resolved_configs;
+    KeyTable key_table;
+    std::vector<ResolvedKey> resolved_keys;
+    std::mutex producer_queues_mutex;
+    std::vector<std::shared_ptr<ProducerQueue>> producer_queues;
+    std::atomic<bool> use_producer_rings{false};
+    std::atomic<bool> coalesce_updates{false};
+    std::atomic<size_t> queue_capacity{0};
+    std::atomic<QueueOverflowPolicy> overflow_policy{QueueOverflowPolicy::kDropOldest};
+    std::atomic<uint64_t> dropped_updates{0};
+    std::atomic<size_t> producer_ring_capacity{4096};
+    std::atomic<uint32_t> zone_threads{0};
+    std::mutex zone_buffers_mutex;
+    std::vector<std::shared_ptr<ZoneBuffer>> zone_buffers;
+    std::mutex histogram_buffers_mutex;
+    std::vector<std::shared_ptr<HistogramBuffer>> histogram_buffers;
+    std::mutex metrics_mutex;
+    std::vector<MetricEntry> metrics;
+    std::mutex snapshots_mutex;
+    std::vector<SnapshotEntry> snapshots;
+    // render_on_change: producers wake the render loop once per flush.
+    std::atomic<bool> render_on_change{false};
+    std::atomic<bool> wake_pending{false};
+    std::mutex app_mutex;
+    DebugVisualizerApp* app = nullptr;
+    // Service thread only.
+    recording::Recorder recorder;
+    stream::Sender sender;
+    shm::Publisher publisher;
+    ServiceCounters counters;
+    ZoneAggregator zones;
+    FlushPool flush_pool;
+    TabGroups tab_groups;
+    TouchedTabs touched;
+    // Set when every metric must be shown again, e.g. after clear_tab().
+    bool republish_metrics = false;
     std::thread thread;
     DebugVisualizerAppOptions options;
     std::string tile_id = "Main";
     std::atomic<bool> thread_started{false};
     std::atomic<bool> running{false};
     std::atomic<bool> stop_requested{false};
+    std::atomic<bool> start_failed{false};
+    // Set by ShowBackgroundVisualizerWindow(), taken by the next frame.
+    std::atomic<bool> window_requested{false};
+    // Written by the service thread once per frame.
+    std::mutex stats_mutex;
+    VisualizerStats stats;
 
     ServiceState() = default;
 
     ~ServiceState() {
         stop_requested.store(true, std::memory_order_release);
         if (thread_started.load(std::memory_order_acquire)) {
-            std::lock_guard<std::mutex> lock(mutex);
-            pending_updates.emplace_back([](DebugVisualizerApp& app) {
+            UpdateRecord close;
+            close.extra().custom = [](DebugVisualizerApp& app) {
                 app.request_close();
-            });
+            };
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending_updates.push(std::move(close), false);
+            }
+            std::lock_guard<std::mutex> lock(app_mutex);
+            if (app) {
+                app->request_redraw();
+            }
+        }
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+};
+
+ServiceState& GetState() {
+    static ServiceState state;
+    return state;
+}
+
+struct ProducerQueueHandle {
+    std::shared_ptr<ProducerQueue> queue;
+
+    ~ProducerQueueHandle() {
+        if (queue) {
+            queue->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+ProducerQueue& LocalProducerQueue() {
+    thread_local ProducerQueueHandle handle;
+    if (!handle.queue) {
+        ServiceState& state = GetState();
+        handle.queue = std::make_shared<ProducerQueue>(state.producer_ring_capacity.load(std::memory_order_relaxed));
+        std::lock_guard<std::mutex> lock(state.producer_queues_mutex);
+        state.producer_queues.push_back(handle.queue);
+    }
+    return *handle.queue;
+}
+
+uint32_t InternName(const std::string& name) {
+    thread_local std::unordered_map<std::string, uint32_t> cache;
+    auto cached = cache.find(name);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+
+    NameTable& table = GetState().name_table;
+    uint32_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto [it, inserted] = table.ids.try_emplace(name, static_cast<uint32_t>(table.names.size()));
+        if (inserted) {
+            table.names.push_back(name);
+        }
+        id = it->second;
+    }
+    cache.emplace(name, id);
+    return id;
+}
+
+// Service-thread only: maps an interned ID back to its name, refreshing the
+// local mirror of the name table when a new ID shows up.
+const std::string& NameOf(uint32_t id) {
+    ServiceState& state = GetState();
+    if (id >= state.resolved_names.size()) {
+        std::lock_guard<std::mutex> lock(state.name_table.mutex);
+        const auto& names = state.name_table.names;
+        state.resolved_names.insert(state.resolved_names.end(),
+                                    names.begin() + static_cast<std::ptrdiff_t>(state.resolved_names.size()),
+                                    names.end());
+    }
+    return state.resolved_names[id];
+}
+
+bool SameGraphConfig(const GraphConfig& a, const GraphConfig& b) {
+    return a.max_samples == b.max_samples && a.auto_scale == b.auto_scale && a.manual_min == b.manual_min &&
+           a.manual_max == b.manual_max && a.level_of_detail == b.level_of_detail;
+}
+
+// Returns kUninternedGraphConfig once the table is full; such records carry
+// the config in their payload instead.
+uint16_t InternGraphConfig(const GraphConfig& config) {
+    static const GraphConfig kDefault;
+    if (SameGraphConfig(config, kDefault)) {
+        return kDefaultGraphConfig;
+    }
+    thread_local std::vector<std::pair<GraphConfig, uint16_t>> cache;
+    for (const auto& [cached, id] : cache) {
+        if (SameGraphConfig(cached, config)) {
+            return id;
+        }
+    }
+
+    ConfigTable& table = GetState().config_table;
+    uint16_t id = kUninternedGraphConfig;
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        for (size_t i = 0; i < table.configs.size(); ++i) {
+            if (SameGraphConfig(table.configs[i], config)) {
+                id = static_cast<uint16_t>(i);
+                break;
+            }
+        }
+        if (id == kUninternedGraphConfig && table.configs.size() < kUninternedGraphConfig) {
+            id = static_cast<uint16_t>(table.configs.size());
+            table.configs.push_back(config);
+        }
+    }
+    if (id != kUninternedGraphConfig) {
+        cache.emplace_back(config, id);
+    }
+    return id;
+}
+
+// Service-thread only, like NameOf(): the config a graph record was
+// published with.
+const GraphConfig& GraphConfigOf(const UpdateRecord& update) {
+    if (update.payload) {
+        return update.payload->config;
+    }
+    ServiceState& state = GetState();
+    if (update.config >= state.resolved_configs.size()) {
+        std::lock_guard<std::mutex> lock(state.config_table.mutex);
+        const auto& configs = state.config_table.configs;
+        state.resolved_configs.insert(state.resolved_configs.end(),
+                                      configs.begin() + static_cast<std::ptrdiff_t>(state.resolved_configs.size()),
+                                      configs.end());
+    }
+    return state.resolved_configs[update.config];
+}
+
+Key RegisterKey(uint32_t tab, const std::string& key, bool is_graph, const GraphConfig& config) {
+    KeyInfo info;
+    info.tab = tab;
+    info.key = InternName(key);
+    info.is_graph = is_graph;
+    info.config = config;
+
+    KeyTable& table = GetState().key_table;
+    const uint64_t pair = (static_cast<uint64_t>(info.tab) << 32) | info.key;
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto& ids = is_graph ? table.graph_ids : table.value_ids;
+    auto [it, inserted] = ids.try_emplace(pair, static_cast<uint32_t>(table.keys.size()));
+    if (inserted) {
+        table.keys.push_back(info);
+    }
+    Key handle;
+    handle.id = it->second;
+    return handle;
+}
+
+CoalesceKey CoalesceKeyOf(const UpdateRecord& update) {
+    if (update.op != UpdateOp::kKeyedValue) {
+        return CoalesceKey{update.op, update.tab, update.key};
+    }
+    // Registered keys never change, so each thread copies the names once.
+    thread_local std::vector<std::pair<uint32_t, uint32_t>> names;
+    if (update.key >= names.size()) {
+        KeyTable& table = GetState().key_table;
+        std::lock_guard<std::mutex> lock(table.mutex);
+        for (size_t i = names.size(); i < table.keys.size(); ++i) {
+            names.emplace_back(table.keys[i].tab, table.keys[i].key);
+        }
+    }
+    if (update.key >= names.size()) {
+        return CoalesceKey{update.op, UINT32_MAX, update.key};
+    }
+    return CoalesceKey{UpdateOp::kValue, names[update.key].first, names[update.key].second};
+}
+
+// Set for the service thread's lifetime. Structure builders, custom
+// closures and anything else it runs may publish too.
+thread_local bool t_on_service_thread = false;
+
+// Applies the configured overflow policy before `update` joins `queue`, with
+// `lock` held on the queue's mutex. Returns false when the update is dropped.
+// Barriers are always let through and never dropped.
+// kBlock waits for the service thread to drain, but gives up (and drops)
+// once the service is no longer running so a dead renderer cannot wedge us.
+// The service thread itself would wait on its own drain, so it skips the
+// bound instead.
+bool MakeRoom(UpdateQueue& queue,
+              std::unique_lock<std::mutex>& lock,
+              std::condition_variable& space,
+              const UpdateRecord& update,
+              bool coalesce) {
+    ServiceState& state = GetState();
+    const size_t capacity = state.queue_capacity.load(std::memory_order_relaxed);
+    if (capacity == 0 || IsBarrier(update.op)) {
+        return true;
+    }
+    while (queue.bounded_size() >= capacity && !queue.would_coalesce(update, coalesce)) {
+        switch (state.overflow_policy.load(std::memory_order_relaxed)) {
+            case QueueOverflowPolicy::kDropNewest:
+                state.dropped_updates.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case QueueOverflowPolicy::kDropOldest:
+                queue.drop_oldest();
+                state.dropped_updates.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            case QueueOverflowPolicy::kBlock:
+                if (t_on_service_thread) {
+                    return true;
+                }
+                if (!state.thread_started.load(std::memory_order_acquire)) {
+                    state.dropped_updates.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                space.wait_for(lock, std::chrono::milliseconds(10));
+                break;
+        }
+    }
+    return true;
+}
+
+void PushToProducerQueue(ProducerQueue& queue, UpdateRecord update, bool coalesce) {
+    const bool to_overflow = coalesce && IsCoalescable(update.op);
+    if (!to_overflow && !queue.overflowing.load(std::memory_order_acquire) && queue.ring.try_push(update)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(queue.overflow_mutex);
+    if (!MakeRoom(queue.overflow, lock, queue.overflow_space, update, coalesce)) {
+        return;
+    }
+    queue.overflow.push(std::move(update), coalesce);
+    queue.overflowing.store(true, std::memory_order_release);
+}
+
+// Returns the record storage the remaining producer queues reserve.
+size_t DrainProducerQueues(std::vector<UpdateRecord>& updates) {
+    ServiceState& state = GetState();
+    size_t reserved = 0;
+    std::lock_guard<std::mutex> registry_lock(state.producer_queues_mutex);
+    auto& queues = state.producer_queues;
+    for (auto it = queues.begin(); it != queues.end();) {
+        ProducerQueue& queue = **it;
+        const bool retired = queue.retired.load(std::memory_order_acquire);
+        {
+            // Holding the overflow lock while draining the ring keeps a
+            // concurrent spill from overtaking updates still in the ring.
+            std::lock_guard<std::mutex> lock(queue.overflow_mutex);
+            queue.ring.drain(updates);
+            queue.overflow.take(updates);
+            queue.overflowing.store(false, std::memory_order_release);
+            if (!retired) {
+                reserved += queue.ring.reserved_bytes() + queue.overflow.reserved_bytes();
+            }
+        }
+        queue.overflow_space.notify_all();
+        it = retired ? queues.erase(it) : it + 1;
+    }
+    return reserved;
+}
+
+void DiscardPendingUpdates() {
+    ServiceState& state = GetState();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.pending_updates.clear();
+    }
+    state.pending_space.notify_all();
+    std::vector<UpdateRecord> discarded;
+    DrainProducerQueues(discarded);
+}
+
+DebugVisualizer::Tab& EnsureTab(DebugVisualizerApp& app, const std::string& tab_id) {
+    ServiceState& state = GetState();
+    DebugVisualizer& tile = app.Tiles[state.tile_id];
+    return tile.tabs[tab_id];
+}
+
+ResolvedKey* ResolveKey(DebugVisualizerApp& app, uint32_t id) {
+    ServiceState& state = GetState();
+    if (id >= state.resolved_keys.size()) {
+        std::lock_guard<std::mutex> lock(state.key_table.mutex);
+        const auto& keys = state.key_table.keys;
+        if (id >= keys.size()) {
+            return nullptr;
+        }
+        for (size_t i = state.resolved_keys.size(); i < keys.size(); ++i) {
+            ResolvedKey resolved;
+            resolved.info = keys[i];
+            state.resolved_keys.push_back(resolved);
+        }
+    }
+
+    ResolvedKey& resolved = state.resolved_keys[id];
+    if (!resolved.tab) {
+        resolved.tab = &EnsureTab(app, NameOf(resolved.info.tab));
+    } else if (resolved.generation == resolved.tab->generation() && (resolved.scalar || resolved.graph)) {
+        return &resolved;
+    }
+    resolved.generation = resolved.tab->generation();
+    const std::string& key = NameOf(resolved.info.key);
+    if (resolved.info.is_graph) {
+        resolved.scalar = nullptr;
+        resolved.graph = &resolved.tab->Graph.add(key, resolved.info.config);
+    } else {
+        resolved.scalar = &resolved.tab->scalar_slot(key);
+        resolved.graph = nullptr;
+    }
+    return &resolved;
+}
+
+void TouchTab(const DebugVisualizer::Tab* tab) {
+    TouchedTabs& touched = GetState().touched;
+    if (touched.active && tab && tab != touched.last) {
+        touched.last = tab;
+        touched.tabs.insert(tab);
+    }
+}
+
+void RecordZones(DebugVisualizerApp& app, const ZoneBatch& batch) {
+    DebugVisualizer::Tab& tab = EnsureTab(app, kProfilerTab);
+    TouchTab(&tab);
+    DebugVisualizer::ZoneTimeline& timeline = tab.zone_timeline(kZoneTimelineKey);
+    const uint32_t lane = timeline.lane_id("thread " + std::to_string(batch.thread));
+    ZoneAggregator& zones = GetState().zones;
+    for (const ZoneEvent& event : batch.events) {
+        const std::string& name = NameOf(event.site);
+        DebugVisualizer::ZoneTimeline::Zone zone;
+        zone.lane = lane;
+        zone.name = timeline.name_id(name);
+        zone.depth = event.depth;
+        zone.begin = static_cast<double>(event.begin_ns) * 1e-9;
+        zone.end = static_cast<double>(event.end_ns) * 1e-9;
+        timeline.push(zone);
+
+        auto [it, inserted] = zones.sites.try_emplace(event.site);
+        if (inserted) {
+            it->second.mean_key = InternName(name + " mean (ms)");
+            it->second.p99_key = InternName(name + " p99 (ms)");
+        }
+        it->second.durations_ms.push_back(static_cast<float>(static_cast<double>(event.end_ns - event.begin_ns) * 1e-6));
+    }
+}
+
+// False for updates that reach beyond one tab or run user code; those are
+// only applied by ApplyUpdate(), in queue order.
+bool ResolveTarget(DebugVisualizerApp& app, const UpdateRecord& update, ApplyTarget& target) {
+    target = ApplyTarget{};
+    switch (update.op) {
+        case UpdateOp::kKeyedValue:
+        case UpdateOp::kKeyedGraphSample:
+            if (ResolvedKey* resolved = ResolveKey(app, update.key)) {
+                target.tab = resolved->tab;
+                target.scalar = resolved->scalar;
+                target.graph = resolved->graph;
+            }
+            return true;
+        case UpdateOp::kGraphSample:
+        case UpdateOp::kGraphSamples:
+            target.config = &GraphConfigOf(update);
+            target.tab = &EnsureTab(app, NameOf(update.tab));
+            target.key = &NameOf(update.key);
+            return true;
+        case UpdateOp::kValue:
+        case UpdateOp::kSeriesConfig:
+        case UpdateOp::kSeriesSample:
+        case UpdateOp::kHistogram:
+            target.tab = &EnsureTab(app, NameOf(update.tab));
+            target.key = &NameOf(update.key);
+            return true;
+        case UpdateOp::kZones:
+        case UpdateOp::kClearTab:
+        case UpdateOp::kStructure:
+        case UpdateOp::kCustom:
+            break;
+    }
+    return false;
+}
+
+// Safe to run concurrently for targets in different tabs.
+void ApplyToTarget(UpdateRecord& update, const ApplyTarget& target) {
+    switch (update.op) {
+        case UpdateOp::kValue:
+            std::visit(
+                [&](auto& v) {
+                    target.tab->update_value(*target.key, std::move(v));
+                },
+                update.value);
+            break;
+        case UpdateOp::kGraphSample: {
+            DebugVisualizer::Graph& graph = target.tab->Graph.add(*target.key, *target.config);
+            graph.x = update.sample;
+            break;
+        }
+        case UpdateOp::kKeyedValue:
+            if (target.scalar) {
+                target.scalar->set(std::move(update.value));
+            }
+            break;
+        case UpdateOp::kKeyedGraphSample:
+            if (target.graph) {
+                target.graph->push(update.sample);
+            }
+            break;
+        case UpdateOp::kGraphSamples:
+            target.tab->add_graph_samples(*target.key, std::move(update.payload->samples), *target.config);
+            break;
+        case UpdateOp::kSeriesConfig:
+            target.tab->configure_series(*target.key, *update.payload->series_config);
+            break;
+        case UpdateOp::kSeriesSample: {
+            const UpdatePayload& row = *update.payload;
+            target.tab->push_series_sample(*target.key, row.time, row.samples.data(), row.samples.size());
+            break;
+        }
+        case UpdateOp::kHistogram:
+            target.tab->merge_histogram(*target.key, *update.payload->histogram);
+            break;
+        case UpdateOp::kZones:
+        case UpdateOp::kClearTab:
+        case UpdateOp::kStructure:
+        case UpdateOp::kCustom:
+            break;
+    }
+}
+
+void ApplyUpdate(DebugVisualizerApp& app, UpdateRecord& update) {
+    ApplyTarget target;
+    if (ResolveTarget(app, update, target)) {
+        TouchTab(target.tab);
+        ApplyToTarget(update, target);
+        return;
+    }
+    switch (update.op) {
+        case UpdateOp::kZones:
+            RecordZones(app, *update.payload->zones);
+            break;
+        case UpdateOp::kClearTab: {
+            DebugVisualizer::Tab& tab = EnsureTab(app, NameOf(update.tab));
+            tab.clear();
+            TouchTab(&tab);
+            GetState().republish_metrics = true;
+            break;
+        }
+        case UpdateOp::kStructure:
+            if (update.payload && update.payload->custom) {
+                update.payload->custom(app);
+            }
+            break;
+        case UpdateOp::kCustom:
+            // Could have changed anything.
+            GetState().touched.all = true;
+            if (update.payload && update.payload->custom) {
+                update.payload->custom(app);
+            }
+            break;
+        case UpdateOp::kValue:
+        case UpdateOp::kGraphSample:
+        case UpdateOp::kKeyedValue:
+        case UpdateOp::kKeyedGraphSample:
+        case UpdateOp::kGraphSamples:
+        case UpdateOp::kSeriesConfig:
+        case UpdateOp::kSeriesSample:
+        case UpdateOp::kHistogram:
+            break;
+    }
+}
+
+// kCustom records are opaque closures and are not encoded; their effect is
+// captured by the next keyframe. Zone timelines are live-only, but the
+// per-zone graphs they feed are encoded as ordinary graph samples.
+void EncodeUpdate(DebugVisualizerApp& app, const UpdateRecord& update, recording::Encoder& out) {
+    switch (update.op) {
+        case UpdateOp::kValue:
+            out.value(NameOf(update.tab), NameOf(update.key), update.value);
+            break;
+        case UpdateOp::kGraphSample:
+            out.graph_sample(NameOf(update.tab), NameOf(update.key), GraphConfigOf(update), update.sample);
+            break;
+        case UpdateOp::kKeyedValue:
+            if (ResolvedKey* resolved = ResolveKey(app, update.key); resolved && resolved->scalar) {
+                out.value(NameOf(resolved->info.tab), NameOf(resolved->info.key), update.value);
+            }
+            break;
+        case UpdateOp::kKeyedGraphSample:
+            if (ResolvedKey* resolved = ResolveKey(app, update.key); resolved && resolved->graph) {
+                out.graph_sample(NameOf(resolved->info.tab), NameOf(resolved->info.key), resolved->info.config,
+                                 update.sample);
+            }
+            break;
+        case UpdateOp::kGraphSamples:
+            out.graph_samples(NameOf(update.tab), NameOf(update.key), GraphConfigOf(update), update.payload->samples);
+            break;
+        case UpdateOp::kSeriesConfig:
+            out.series_config(NameOf(update.tab), NameOf(update.key), *update.payload->series_config);
+            break;
+        case UpdateOp::kSeriesSample:
+            out.series_sample(NameOf(update.tab), NameOf(update.key), update.payload->time, update.payload->samples);
+            break;
+        case UpdateOp::kStructure: {
+            // A hidden tab only holds on to the builder; EncodeShownStructures()
+            // picks the tree up once showing the tab has built it.
+            DebugVisualizer::Tab& tab = EnsureTab(app, NameOf(update.tab));
+            if (tab.is_shown()) {
+                const std::string& key = NameOf(update.key);
+                out.structure(NameOf(update.tab), key, tab.get_structure(key));
+            }
+            break;
+        }
+        case UpdateOp::kClearTab:
+            out.clear_tab(NameOf(update.tab));
+            break;
+        case UpdateOp::kHistogram:
+            out.histogram(NameOf(update.tab), NameOf(update.key), *update.payload->histogram);
+            break;
+        case UpdateOp::kZones:
+        case UpdateOp::kCustom:
+            break;
+    }
+}
+
+// Reads every Counter and Gauge and publishes the ones that changed as
+// keyed values, so they are recorded and streamed like value().
+template <typename Encode>
+void PublishMetrics(DebugVisualizerApp& app, const Encode& encode) {
+    ServiceState& state = GetState();
+    const bool republish = state.republish_metrics;
+    state.republish_metrics = false;
+    std::lock_guard<std::mutex> lock(state.metrics_mutex);
+    std::vector<MetricEntry>& metrics = state.metrics;
+    for (size_t i = 0; i < metrics.size();) {
+        MetricEntry& metric = metrics[i];
+        // Checked before reading so the final value is still published.
+        const bool orphaned = metric.counter ? metric.counter.use_count() == 1 : metric.gauge.use_count() == 1;
+        ScalarValue value;
+        bool has_value = true;
+        if (metric.counter) {
+            int64_t total = 0;
+            for (size_t shard = 0; shard < Counter::kShards; ++shard) {
+                total += metric.counter[shard].value.load(std::memory_order_relaxed);
+            }
+            value = total;
+        } else {
+            const double gauge = metric.gauge->value.load(std::memory_order_relaxed);
+            has_value = !std::isnan(gauge);
+            value = gauge;
+        }
+        // Most metrics are unchanged most frames, so the record is only built
+        // for the ones that moved.
+        if (has_value && (republish || !metric.published || value != metric.last)) {
+            UpdateRecord update;
+            update.op = UpdateOp::kKeyedValue;
+            update.key = metric.key.id;
+            update.value = value;
+            metric.last = std::move(value);
+            metric.published = true;
+            encode(update);
+            ApplyUpdate(app, update);
+        }
+        if (orphaned) {
+            if (i + 1 != metrics.size()) {
+                metric = std::move(metrics.back());
+            }
+            metrics.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+// Graphs each zone's mean and nearest-rank p99 over the interval, through
+// the same apply/encode path as published samples.
+template <typename Encode>
+void EmitZoneStats(DebugVisualizerApp& app, const Encode& encode) {
+    ZoneAggregator& zones = GetState().zones;
+    const auto now = std::chrono::steady_clock::now();
+    if (zones.sites.empty() || now < zones.next_emit) {
+        return;
+    }
+    zones.next_emit = now + kZoneStatsInterval;
+    const uint32_t tab = InternName(kProfilerTab);
+    for (auto& [site, stats] : zones.sites) {
+        std::vector<float>& durations = stats.durations_ms;
+        if (durations.empty()) {
+            continue;
+        }
+        double total = 0.0;
+        for (float duration : durations) {
+            total += duration;
+        }
+        const size_t rank = (durations.size() * 99 + 99) / 100 - 1;
+        std::nth_element(durations.begin(), durations.begin() + static_cast<std::ptrdiff_t>(rank), durations.end());
+
+        UpdateRecord update;
+        update.op = UpdateOp::kGraphSample;
+        update.tab = tab;
+        update.key = stats.mean_key;
+        update.sample = static_cast<float>(total / static_cast<double>(durations.size()));
+        encode(update);
+        ApplyUpdate(app, update);
+        update.key = stats.p99_key;
+        update.sample = durations[rank];
+        encode(update);
+        ApplyUpdate(app, update);
+        durations.clear();
+    }
+}
+
+// Publishes a new snapshot of every tab with a live TabReader that this
+// flush changed, and drops the entries whose readers are all gone.
+void PublishSnapshots(DebugVisualizerApp& app) {
+    ServiceState& state = GetState();
+    TouchedTabs& touched = state.touched;
+    std::lock_guard<std::mutex> lock(state.snapshots_mutex);
+    std::vector<SnapshotEntry>& snapshots = state.snapshots;
+    DebugVisualizer& tile = app.Tiles[state.tile_id];
+    for (size_t i = 0; i < snapshots.size();) {
+        SnapshotEntry& entry = snapshots[i];
+        if (entry.slot.use_count() == 1) {
+            if (i + 1 != snapshots.size()) {
+                entry = std::move(snapshots.back());
+            }
+            snapshots.pop_back();
+            continue;
+        }
+        const DebugVisualizer::Tab* tab = tile.find_tab(NameOf(entry.tab));
+        if (!tab) {
+            if (touched.all) {
+                std::atomic_store(&entry.slot->latest, std::shared_ptr<const TabSnapshot>());
+            }
+        } else if (entry.fresh || touched.all || touched.tabs.count(tab) != 0) {
+            // Only this thread stores into the slot.
+            const std::shared_ptr<const TabSnapshot> previous =
+                entry.fresh ? nullptr : std::atomic_load(&entry.slot->latest);
+            std::atomic_store(&entry.slot->latest, tab->snapshot(previous.get()));
+            entry.fresh = false;
+        }
+        ++i;
+    }
+    touched.active = !snapshots.empty();
+    touched.all = false;
+    touched.last = nullptr;
+    touched.tabs.clear();
+}
+
+template <typename Encode>
+void EncodeAndApply(DebugVisualizerApp& app, UpdateRecord& update, const Encode& encode) {
+    // Structures are encoded as the tree their builder produced.
+    const bool is_structure = update.op == UpdateOp::kStructure;
+    if (!is_structure) {
+        encode(update);
+    }
+    ApplyUpdate(app, update);
+    if (is_structure) {
+        encode(update);
+    }
+}
+
+// Applies updates[begin, end), all tab-local with their targets resolved,
+// one tab per flush worker; the largest tabs are handed out first.
+void ApplyByTab(std::vector<UpdateRecord>& updates, size_t begin, size_t end) {
+    ServiceState& state = GetState();
+    TabGroups& scratch = state.tab_groups;
+    scratch.index.clear();
+    scratch.used = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const DebugVisualizer::Tab* tab = scratch.targets[i].tab;
+        if (!tab) {
+            continue;
+        }
+        auto [it, inserted] = scratch.index.try_emplace(tab, scratch.used);
+        if (inserted) {
+            if (scratch.used == scratch.groups.size()) {
+                scratch.groups.emplace_back();
+            }
+            scratch.groups[scratch.used++].clear();
+        }
+        scratch.groups[it->second].push_back(static_cast<uint32_t>(i));
+    }
+
+    if (end - begin < kParallelApplyMin || scratch.used < 2) {
+        for (size_t i = begin; i < end; ++i) {
+            if (scratch.targets[i].tab) {
+                ApplyToTarget(updates[i], scratch.targets[i]);
+            }
+        }
+        return;
+    }
+    std::sort(scratch.groups.begin(), scratch.groups.begin() + static_cast<std::ptrdiff_t>(scratch.used),
+              [](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+                  return a.size() > b.size();
+              });
+    state.flush_pool.run(scratch.used, [&](size_t group) {
+        for (uint32_t i : scratch.groups[group]) {
+            ApplyToTarget(updates[i], scratch.targets[i]);
+        }
+    });
+}
+
+// Every update is encoded on this thread in queue order. With flush workers,
+// runs of tab-local updates are applied by ApplyByTab(); anything else ends
+// the run and is applied alone once the run is done.
+template <typename Encode>
+void ApplyUpdates(DebugVisualizerApp& app, std::vector<UpdateRecord>& updates, const Encode& encode) {
+    ServiceState& state = GetState();
+    if (state.flush_pool.size() == 0 || updates.size() < kParallelApplyMin) {
+        for (auto& update : updates) {
+            EncodeAndApply(app, update, encode);
+        }
+        return;
+    }
+    std::vector<ApplyTarget>& targets = state.tab_groups.targets;
+    targets.resize(updates.size());
+    size_t begin = 0;
+    while (begin < updates.size()) {
+        size_t end = begin;
+        while (end < updates.size() && ResolveTarget(app, updates[end], targets[end])) {
+            TouchTab(targets[end].tab);
+            encode(updates[end]);
+            ++end;
+        }
+        ApplyByTab(updates, begin, end);
+        if (end < updates.size()) {
+            EncodeAndApply(app, updates[end], encode);
+            ++end;
+        }
+        begin = end;
+    }
+}
+
+// Defined with ZoneBuffer and HistogramBuffer below.
+void TakeDueZones(std::vector<UpdateRecord>& updates);
+void TakeDueHistograms(std::vector<UpdateRecord>& updates);
+
+// Structures built by the last render showing their tab, forwarded before
+// this frame's updates so a later builder still wins.
+void EncodeShownStructures(DebugVisualizerApp& app, recording::Encoder* const* sinks, size_t sink_count) {
+    if (sink_count == 0) {
+        return;
+    }
+    DebugVisualizer& tile = app.Tiles[GetState().tile_id];
+    for (const auto& id : tile.tab_ids()) {
+        DebugVisualizer::Tab* tab = tile.find_tab(id);
+        if (!tab) {
+            continue;
+        }
+        for (const auto& key : tab->take_shown_structures()) {
+            const auto root = tab->get_structure(key);
+            for (size_t i = 0; i < sink_count; ++i) {
+                sinks[i]->structure(id, key, root);
+            }
+        }
+    }
+}
+
+void FlushUpdates(DebugVisualizerApp& app) {
+    ServiceState& state = GetState();
+    const auto begin = ServiceCounters::Clock::now();
+    // flush_buffer is only touched here; swapping it in and out keeps the
+    // capacity of both vectors so steady-state flushing does not allocate.
+    std::vector<UpdateRecord>& updates = state.flush_buffer;
+    // Re-arm the wake-up before draining; see NotifyUpdatePending().
+    state.wake_pending.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.pending_updates.take(updates);
+    }
+    state.pending_space.notify_all();
+    state.counters.producer_bytes = DrainProducerQueues(updates);
+    TakeDueZones(updates);
+    TakeDueHistograms(updates);
+    const size_t depth = updates.size();
+
+    // Updates are encoded once per sink: the recording file and the stream.
+    recording::Encoder* sinks[3];
+    size_t sink_count = 0;
+    if (state.recorder.is_open()) {
+        sinks[sink_count++] = &state.recorder.encoder();
+    }
+    if (state.sender.streaming()) {
+        sinks[sink_count++] = &state.sender.encoder();
+    }
+    if (state.publisher.streaming()) {
+        sinks[sink_count++] = &state.publisher.encoder();
+    }
+    auto encode = [&](const UpdateRecord& update) {
+        for (size_t i = 0; i < sink_count; ++i) {
+            EncodeUpdate(app, update, *sinks[i]);
+        }
+    };
+    EncodeShownStructures(app, sinks, sink_count);
+    ApplyUpdates(app, updates, encode);
+    updates.clear();
+    PublishMetrics(app, encode);
+    EmitZoneStats(app, encode);
+    PublishSnapshots(app);
+    DebugVisualizer& tile = app.Tiles[state.tile_id];
+    state.recorder.end_frame(tile);
+    state.sender.end_frame(tile);
+    state.publisher.end_frame(tile);
+
+    ServiceCounters& counters = state.counters;
+    counters.flush_depth = depth;
+    counters.peak_depth = std::max(counters.peak_depth, depth);
+    counters.applied += depth;
+    counters.flush_ms =
+        std::chrono::duration<double, std::milli>(ServiceCounters::Clock::now() - begin).count();
+}
+
+std::vector<TabStats> CollectTabStats(const DebugVisualizer& tile) {
+    std::vector<TabStats> tabs;
+    for (const auto& id : tile.tab_ids()) {
+        const DebugVisualizer::Tab* tab = tile.find_tab(id);
+        if (!tab) {
+            continue;
         }
-        if (thread.joinable()) {
-            thread.join();
+        TabStats entry;
+        entry.id = id;
+        entry.scalars = tab->scalar_keys().size();
+        entry.structures = tab->structure_keys().size();
+        for (auto& key : tab->graph_keys()) {
+            const size_t bytes = tab->find_graph(key)->memory_bytes();
+            entry.graph_bytes.emplace_back(std::move(key), bytes);
+            ++entry.graphs;
+        }
+        for (auto& key : tab->series_keys()) {
+            const size_t bytes = tab->find_series(key)->memory_bytes();
+            entry.graph_bytes.emplace_back(std::move(key), bytes);
+            ++entry.series;
         }
+        for (auto& key : tab->histogram_keys()) {
+            const size_t bytes = tab->find_histogram(key)->memory_bytes();
+            entry.graph_bytes.emplace_back(std::move(key), bytes);
+            ++entry.histograms;
+        }
+        tabs.push_back(std::move(entry));
     }
-};
+    return tabs;
+}
 
-ServiceState& GetState() {
-    static ServiceState state;
-    return state;
+void ShowInternals(DebugVisualizer& tile, const VisualizerStats& stats) {
+    DebugVisualizer::Tab& tab = tile.window_tile(kInternalsTile).tabs["Service"];
+    tab.update_value("Queue/Depth", static_cast<int64_t>(stats.queue_depth));
+    tab.update_value("Queue/Peak depth", static_cast<int64_t>(stats.peak_queue_depth));
+    tab.update_value("Queue/Reserved bytes", static_cast<int64_t>(stats.queue_bytes));
+    tab.update_value("Updates/Applied", static_cast<int64_t>(stats.updates_applied));
+    tab.update_value("Updates/Per second", stats.updates_per_second);
+    tab.update_value("Updates/Dropped", static_cast<int64_t>(stats.dropped_updates));
+    tab.update_value("Time/FlushUpdates (ms)", stats.flush_ms);
+    tab.update_value("Time/render() (ms)", stats.render_ms);
+    tab.update_value("Time/ImGui::Render (ms)", stats.imgui_render_ms);
+    tab.update_value("Time/Present (ms)", stats.present_ms);
+    tab.update_structure("Tabs", [&stats](StructureBuilder& builder) {
+        for (const auto& entry : stats.tabs) {
+            StructureBuilder node = builder.nested(entry.id);
+            node.field("scalars", static_cast<int64_t>(entry.scalars));
+            node.field("graphs", static_cast<int64_t>(entry.graphs));
+            node.field("series", static_cast<int64_t>(entry.series));
+            node.field("histograms", static_cast<int64_t>(entry.histograms));
+            node.field("structures", static_cast<int64_t>(entry.structures));
+            if (!entry.graph_bytes.empty()) {
+                StructureBuilder memory = node.nested("graph bytes");
+                for (const auto& [key, bytes] : entry.graph_bytes) {
+                    memory.field(key, static_cast<int64_t>(bytes));
+                }
+            }
+        }
+    });
 }
 
-void FlushUpdates(DebugVisualizerApp& app) {
+// Runs after FlushUpdates(); the frame timings are those of the previous
+// frame, the last one run() has finished.
+void UpdateStats(DebugVisualizerApp& app, bool show_internals) {
+    using Clock = ServiceCounters::Clock;
     ServiceState& state = GetState();
-    std::vector<UpdateFn> updates;
+    ServiceCounters& counters = state.counters;
+    const auto now = Clock::now();
+    const double window = std::chrono::duration<double>(now - counters.rate_start).count();
+    if (window >= 1.0) {
+        counters.rate = static_cast<double>(counters.applied - counters.rate_base) / window;
+        counters.rate_base = counters.applied;
+        counters.rate_start = now;
+    }
+
+    size_t queue_bytes = counters.producer_bytes + state.flush_buffer.capacity() * sizeof(UpdateRecord);
     {
         std::lock_guard<std::mutex> lock(state.mutex);
-        updates.swap(state.pending_updates);
+        queue_bytes += state.pending_updates.reserved_bytes();
+    }
+
+    VisualizerStats next;
+    const bool refresh_tabs = now >= counters.next_tab_refresh;
+    if (refresh_tabs) {
+        next.tabs = CollectTabStats(app.Tiles[state.tile_id]);
+        counters.next_tab_refresh = now + std::chrono::milliseconds(500);
+    }
+    const AppFrameStats& frame = app.frame_stats();
+    next.running = true;
+    next.frames = frame.frames;
+    next.queue_depth = counters.flush_depth;
+    next.peak_queue_depth = counters.peak_depth;
+    next.queue_bytes = queue_bytes;
+    next.updates_applied = counters.applied;
+    next.updates_per_second = counters.rate;
+    next.dropped_updates = state.dropped_updates.load(std::memory_order_relaxed);
+    next.flush_ms = counters.flush_ms;
+    next.render_ms = frame.render_ms;
+    next.imgui_render_ms = frame.imgui_render_ms;
+    next.present_ms = frame.present_ms;
+    if (refresh_tabs && show_internals) {
+        ShowInternals(app.Tiles[state.tile_id], next);
+    }
+    std::lock_guard<std::mutex> lock(state.stats_mutex);
+    if (!refresh_tabs) {
+        next.tabs = std::move(state.stats.tabs);
+    }
+    state.stats = std::move(next);
+}
+
+// "<host>/<program>[<pid>]", unique enough to tell producers apart in a
+// viewer fed by several containers.
+std::string DefaultStreamName() {
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) != 0) {
+        host[0] = '\0';
     }
-    for (auto& update : updates) {
-        update(app);
+    std::string program = "process";
+    if (std::FILE* comm = std::fopen("/proc/self/comm", "r")) {
+        char buffer[64] = {};
+        if (std::fgets(buffer, sizeof(buffer), comm)) {
+            program = buffer;
+            while (!program.empty() && (program.back() == '\n' || program.back() == '\r')) {
+                program.pop_back();
+            }
+        }
+        std::fclose(comm);
     }
+    return std::string(host) + "/" + program + "[" + std::to_string(getpid()) + "]";
 }
 
 void PrepareDefaultTab(DebugVisualizerApp& app) {
@@ -83,6 +1598,7 @@ void PrepareDefaultTab(DebugVisualizerApp& app) {
 
 void ServiceThread() {
     ServiceState& state = GetState();
+    t_on_service_thread = true;
 
     DebugVisualizerAppOptions options;
     {
@@ -90,37 +1606,91 @@ void ServiceThread() {
         options = state.options;
     }
 
+    const std::string record_path = options.record_path;
+    const size_t keyframe_interval = options.record_keyframe_interval;
+    const std::string stream_address = options.stream_address;
+    const std::string stream_name = options.stream_name.empty() ? DefaultStreamName() : options.stream_name;
+    const size_t shm_capacity = options.shm_ring_capacity;
+    const bool show_internals = options.show_internals;
+    const size_t flush_threads = options.flush_threads;
     DebugVisualizerApp app(std::move(options));
-    state.running.store(true, std::memory_order_release);
+    state.counters = ServiceCounters{};
+    // Keys registered before a restart must not point into the old app.
+    for (ResolvedKey& resolved : state.resolved_keys) {
+        resolved.tab = nullptr;
+        resolved.scalar = nullptr;
+        resolved.graph = nullptr;
+    }
+    state.zones = ZoneAggregator{};
+    state.republish_metrics = true;
+    {
+        // Snapshots of the previous app's tabs share nothing with this one.
+        std::lock_guard<std::mutex> lock(state.snapshots_mutex);
+        for (SnapshotEntry& entry : state.snapshots) {
+            entry.fresh = true;
+        }
+    }
+    state.flush_pool.start(flush_threads);
+    {
+        std::lock_guard<std::mutex> lock(state.app_mutex);
+        state.app = &app;
+    }
+    if (!record_path.empty() && !state.recorder.open(record_path, state.tile_id, keyframe_interval)) {
+        std::fprintf(stderr, "Failed to open recording %s\n", record_path.c_str());
+    }
+    if (stream_address.rfind(shm::kScheme, 0) == 0) {
+        if (!state.publisher.open(stream_name, shm_capacity)) {
+            std::fprintf(stderr, "Failed to create shared-memory segment for %s\n", stream_name.c_str());
+        }
+    } else if (!stream_address.empty() && !state.sender.open(stream_address, stream_name)) {
+        std::fprintf(stderr, "Invalid stream address %s\n", stream_address.c_str());
+    }
 
     auto frame_callback = [&](DebugVisualizerApp& ctx, float /*elapsed*/, float /*delta*/) {
         if (state.stop_requested.load(std::memory_order_acquire)) {
             ctx.request_close();
         }
+        if (state.window_requested.load(std::memory_order_relaxed) &&
+            state.window_requested.exchange(false, std::memory_order_acq_rel)) {
+            ctx.attach_window();
+        }
         PrepareDefaultTab(ctx);
         FlushUpdates(ctx);
+        UpdateStats(ctx, show_internals);
     };
 
-    app.run(frame_callback);
+    if (app.run(frame_callback) != 0) {
+        // Don't respawn on every publish after e.g. a failed window creation;
+        // an explicit StartBackgroundVisualizer() retries.
+        state.start_failed.store(true, std::memory_order_release);
+    }
 
-    state.running.store(false, std::memory_order_release);
-    state.thread_started.store(false, std::memory_order_release);
+    state.flush_pool.stop();
+    state.recorder.close();
+    state.sender.close();
+    state.publisher.close();
     {
-        std::lock_guard<std::mutex> lock(state.mutex);
-        state.pending_updates.clear();
+        std::lock_guard<std::mutex> lock(state.app_mutex);
+        state.app = nullptr;
     }
+    state.running.store(false, std::memory_order_release);
+    state.thread_started.store(false, std::memory_order_release);
+    DiscardPendingUpdates();
     state.stop_requested.store(false, std::memory_order_release);
 }
 
-void EnsureThreadStarted() {
+bool EnsureThreadStarted() {
     ServiceState& state = GetState();
     if (state.thread_started.load(std::memory_order_acquire)) {
-        return;
+        return true;
+    }
+    if (state.start_failed.load(std::memory_order_acquire)) {
+        return false;
     }
 
     std::lock_guard<std::mutex> lock(state.mutex);
     if (state.thread_started.load(std::memory_order_acquire)) {
-        return;
+        return true;
     }
 
     if (state.thread.joinable()) {
@@ -128,25 +1698,359 @@ void EnsureThreadStarted() {
     }
 
     state.stop_requested.store(false, std::memory_order_release);
+    // Updates queue up from here on, so callers need not wait for the
+    // backend (and with it GL) to come up.
+    state.running.store(true, std::memory_order_release);
     state.thread = std::thread(ServiceThread);
     state.thread_started.store(true, std::memory_order_release);
+    return true;
 }
 
-void EnqueueUpdate(UpdateFn update) {
+void WakeServiceLoop() {
     ServiceState& state = GetState();
-    std::lock_guard<std::mutex> lock(state.mutex);
-    state.pending_updates.emplace_back(std::move(update));
+    std::lock_guard<std::mutex> lock(state.app_mutex);
+    if (state.app) {
+        state.app->request_redraw();
+    }
 }
 
-void PostUpdate(UpdateFn update) {
-    EnsureThreadStarted();
-    EnqueueUpdate(std::move(update));
+// Only the first update after a flush wakes the loop. The fences pair
+// with FlushUpdates(): either it drains this update or we see the re-armed
+// flag.
+void NotifyUpdatePending() {
+    ServiceState& state = GetState();
+    if (!state.render_on_change.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (state.wake_pending.load(std::memory_order_relaxed) ||
+        state.wake_pending.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    WakeServiceLoop();
 }
 
-DebugVisualizer::Tab& EnsureTab(DebugVisualizerApp& app, const std::string& tab_id) {
+void EnqueueUpdate(UpdateRecord update) {
     ServiceState& state = GetState();
-    DebugVisualizer& tile = app.Tiles[state.tile_id];
-    return tile.tabs[tab_id];
+    const bool coalesce = state.coalesce_updates.load(std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(state.mutex);
+    if (!MakeRoom(state.pending_updates, lock, state.pending_space, update, coalesce)) {
+        return;
+    }
+    state.pending_updates.push(std::move(update), coalesce);
+}
+
+void PostUpdate(UpdateRecord update) {
+    if (!EnsureThreadStarted()) {
+        return;
+    }
+    ServiceState& state = GetState();
+    if (state.use_producer_rings.load(std::memory_order_relaxed)) {
+        PushToProducerQueue(LocalProducerQueue(), std::move(update),
+                            state.coalesce_updates.load(std::memory_order_relaxed));
+    } else {
+        EnqueueUpdate(std::move(update));
+    }
+    NotifyUpdatePending();
+}
+
+void PostCustom(UpdateFn fn) {
+    UpdateRecord update;
+    update.extra().custom = std::move(fn);
+    PostUpdate(std::move(update));
+}
+
+void PostValue(const std::string& tab_id, const std::string& key, ScalarValue value) {
+    UpdateRecord update;
+    update.op = UpdateOp::kValue;
+    update.tab = InternName(tab_id);
+    update.key = InternName(key);
+    update.value = std::move(value);
+    PostUpdate(std::move(update));
+}
+
+void PostKeyedValue(Key key, ScalarValue value) {
+    if (!key.valid()) {
+        return;
+    }
+    UpdateRecord update;
+    update.op = UpdateOp::kKeyedValue;
+    update.key = key.id;
+    update.value = std::move(value);
+    PostUpdate(std::move(update));
+}
+
+// Zones that ended on one thread and have not been posted yet. Only the
+// owning thread appends; `mutex_` lets the service thread take a batch the
+// owner has stopped adding to, see TakeDueZones().
+class ZoneBuffer {
+public:
+    ZoneBuffer() : thread_(GetState().zone_threads.fetch_add(1, std::memory_order_relaxed) + 1) {
+        events_.reserve(kZoneBatchSize);
+    }
+
+    void begin() {
+        ++depth_;
+    }
+
+    void end(uint32_t site, int64_t begin_ns, int64_t end_ns) {
+        --depth_;
+        std::unique_lock<SpinLock> lock(mutex_);
+        events_.push_back(ZoneEvent{site, depth_, begin_ns, end_ns});
+        if (events_.size() >= kZoneBatchSize || end_ns - events_.front().end_ns >= kZoneBatchNs) {
+            post(lock);
+        }
+    }
+
+    void post() {
+        std::unique_lock<SpinLock> lock(mutex_);
+        post(lock);
+    }
+
+    // Service thread: takes the batch once its oldest zone is kZoneBatchNs
+    // old, unless the owner is posting one (which would then arrive late).
+    void take_due(int64_t now_ns, std::vector<UpdateRecord>& out) {
+        std::lock_guard<SpinLock> lock(mutex_);
+        if (!posting_ && !events_.empty() && now_ns - events_.front().end_ns >= kZoneBatchNs) {
+            out.push_back(take());
+        }
+    }
+
+    // Thread exit. Other thread-locals, the producer ring among them, may
+    // already be gone, so the remainder goes through the shared queue and
+    // never starts the service.
+    void retire() {
+        std::unique_lock<SpinLock> lock(mutex_);
+        retired_.store(true, std::memory_order_release);
+        if (events_.empty() || !GetState().thread_started.load(std::memory_order_acquire)) {
+            return;
+        }
+        UpdateRecord update = take();
+        lock.unlock();
+        EnqueueUpdate(std::move(update));
+        NotifyUpdatePending();
+    }
+
+    bool retired() const {
+        return retired_.load(std::memory_order_acquire);
+    }
+
+private:
+    // Posting can block on a full queue, so it happens outside `mutex_`.
+    void post(std::unique_lock<SpinLock>& lock) {
+        if (events_.empty()) {
+            return;
+        }
+        UpdateRecord update = take();
+        posting_ = true;
+        lock.unlock();
+        PostUpdate(std::move(update));
+        lock.lock();
+        posting_ = false;
+    }
+
+    UpdateRecord take() {
+        auto batch = std::make_shared<ZoneBatch>();
+        batch->thread = thread_;
+        batch->events.swap(events_);
+        events_.reserve(kZoneBatchSize);
+        UpdateRecord update;
+        update.op = UpdateOp::kZones;
+        update.extra().zones = std::move(batch);
+        return update;
+    }
+
+    const uint32_t thread_;
+    uint32_t depth_ = 0;
+    SpinLock mutex_;
+    std::vector<ZoneEvent> events_;
+    bool posting_ = false;
+    std::atomic<bool> retired_{false};
+};
+
+struct ZoneBufferHandle {
+    std::shared_ptr<ZoneBuffer> buffer;
+
+    ~ZoneBufferHandle() {
+        if (buffer) {
+            buffer->retire();
+        }
+    }
+};
+
+void RegisterMetric(MetricEntry entry) {
+    ServiceState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.metrics_mutex);
+    state.metrics.push_back(std::move(entry));
+}
+
+ZoneBuffer& LocalZoneBuffer() {
+    thread_local ZoneBufferHandle handle;
+    if (!handle.buffer) {
+        ServiceState& state = GetState();
+        handle.buffer = std::make_shared<ZoneBuffer>();
+        std::lock_guard<std::mutex> lock(state.zone_buffers_mutex);
+        state.zone_buffers.push_back(handle.buffer);
+    }
+    return *handle.buffer;
+}
+
+// Picks up zones from threads that have stopped ending them, so their last
+// batch does not wait for one more zone, flush_zones() or thread exit.
+void TakeDueZones(std::vector<UpdateRecord>& updates) {
+    ServiceState& state = GetState();
+    const int64_t now = SteadyNanoseconds();
+    std::lock_guard<std::mutex> lock(state.zone_buffers_mutex);
+    auto& buffers = state.zone_buffers;
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        if ((*it)->retired()) {
+            it = buffers.erase(it);
+            continue;
+        }
+        (*it)->take_due(now, updates);
+        ++it;
+    }
+}
+
+// Histogram values recorded on one thread since its last post, one sketch
+// per tab/key, so memory stays bounded by the keys rather than the rate.
+// Guarded like ZoneBuffer, so the service thread can post sketches an idle
+// thread left behind; see TakeDueHistograms().
+class HistogramBuffer {
+public:
+    void add(uint32_t tab, uint32_t key, double value, const HistogramConfig& config) {
+        const int64_t now = SteadyNanoseconds();
+        std::unique_lock<SpinLock> lock(mutex_);
+        auto [it, inserted] = sketches_.try_emplace((static_cast<uint64_t>(tab) << 32) | key, config);
+        if (!inserted && !it->second.same_config(config)) {
+            take_one(it->first, it->second, pending_);
+            it->second = QuantileSketch(config);
+        }
+        it->second.add(value);
+        if (now >= next_post_ns_) {
+            next_post_ns_ = now + kHistogramPostNs;
+            take_all(pending_);
+        }
+        if (!pending_.empty()) {
+            post(lock);
+        }
+    }
+
+    void flush() {
+        std::unique_lock<SpinLock> lock(mutex_);
+        take_all(pending_);
+        post(lock);
+    }
+
+    // Service thread: takes the sketches once they are due, unless the owner
+    // is posting (which would then arrive late).
+    void take_due(int64_t now_ns, std::vector<UpdateRecord>& out) {
+        std::lock_guard<SpinLock> lock(mutex_);
+        if (!posting_ && now_ns >= next_post_ns_) {
+            const size_t taken = out.size();
+            take_all(out);
+            if (out.size() != taken) {
+                next_post_ns_ = now_ns + kHistogramPostNs;
+            }
+        }
+    }
+
+    // See ZoneBuffer::retire().
+    void retire() {
+        std::unique_lock<SpinLock> lock(mutex_);
+        retired_.store(true, std::memory_order_release);
+        if (!GetState().thread_started.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::vector<UpdateRecord> updates;
+        take_all(updates);
+        lock.unlock();
+        for (auto& update : updates) {
+            EnqueueUpdate(std::move(update));
+        }
+        NotifyUpdatePending();
+    }
+
+    bool retired() const {
+        return retired_.load(std::memory_order_acquire);
+    }
+
+private:
+    void post(std::unique_lock<SpinLock>& lock) {
+        std::vector<UpdateRecord> updates;
+        updates.swap(pending_);
+        posting_ = true;
+        lock.unlock();
+        for (auto& update : updates) {
+            PostUpdate(std::move(update));
+        }
+        lock.lock();
+        posting_ = false;
+    }
+
+    void take_all(std::vector<UpdateRecord>& out) {
+        for (auto& [packed, sketch] : sketches_) {
+            take_one(packed, sketch, out);
+        }
+    }
+
+    static void take_one(uint64_t packed, QuantileSketch& sketch, std::vector<UpdateRecord>& out) {
+        if (sketch.empty()) {
+            return;
+        }
+        UpdateRecord update;
+        update.op = UpdateOp::kHistogram;
+        update.tab = static_cast<uint32_t>(packed >> 32);
+        update.key = static_cast<uint32_t>(packed);
+        update.extra().histogram = std::make_shared<const QuantileSketch>(sketch);
+        sketch.clear();
+        out.push_back(std::move(update));
+    }
+
+    SpinLock mutex_;
+    std::unordered_map<uint64_t, QuantileSketch> sketches_;
+    std::vector<UpdateRecord> pending_;
+    int64_t next_post_ns_ = 0;
+    bool posting_ = false;
+    std::atomic<bool> retired_{false};
+};
+
+struct HistogramBufferHandle {
+    std::shared_ptr<HistogramBuffer> buffer;
+
+    ~HistogramBufferHandle() {
+        if (buffer) {
+            buffer->retire();
+        }
+    }
+};
+
+HistogramBuffer& LocalHistogramBuffer() {
+    thread_local HistogramBufferHandle handle;
+    if (!handle.buffer) {
+        ServiceState& state = GetState();
+        handle.buffer = std::make_shared<HistogramBuffer>();
+        std::lock_guard<std::mutex> lock(state.histogram_buffers_mutex);
+        state.histogram_buffers.push_back(handle.buffer);
+    }
+    return *handle.buffer;
+}
+
+// Posts sketches of threads that stopped recording, so their last values do
+// not wait for one more add(), flush_histograms() or thread exit.
+void TakeDueHistograms(std::vector<UpdateRecord>& updates) {
+    ServiceState& state = GetState();
+    const int64_t now = SteadyNanoseconds();
+    std::lock_guard<std::mutex> lock(state.histogram_buffers_mutex);
+    auto& buffers = state.histogram_buffers;
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        if ((*it)->retired()) {
+            it = buffers.erase(it);
+            continue;
+        }
+        (*it)->take_due(now, updates);
+        ++it;
+    }
 }
 
 }  // namespace
@@ -163,10 +2067,18 @@ void StartBackgroundVisualizer(bool enable_docking) {
 
 void StartBackgroundVisualizer(DebugVisualizerAppOptions options) {
     ServiceState& state = GetState();
+    state.use_producer_rings.store(options.producer_queue == ProducerQueueMode::kPerThreadRing,
+                                   std::memory_order_relaxed);
+    state.producer_ring_capacity.store(options.producer_ring_capacity, std::memory_order_relaxed);
+    state.coalesce_updates.store(options.coalesce_updates, std::memory_order_relaxed);
+    state.queue_capacity.store(options.update_queue_capacity, std::memory_order_relaxed);
+    state.overflow_policy.store(options.queue_overflow_policy, std::memory_order_relaxed);
+    state.render_on_change.store(options.render_on_change, std::memory_order_relaxed);
     {
         std::lock_guard<std::mutex> lock(state.mutex);
         state.options = std::move(options);
     }
+    state.start_failed.store(false, std::memory_order_release);
     EnsureThreadStarted();
 }
 
@@ -177,9 +2089,16 @@ void ShutdownBackgroundVisualizer() {
     }
 
     state.stop_requested.store(true, std::memory_order_release);
-    EnqueueUpdate([](DebugVisualizerApp& app) {
+    UpdateRecord close;
+    close.extra().custom = [](DebugVisualizerApp& app) {
         app.request_close();
-    });
+    };
+    {
+        // Bypasses the capacity policy: the close request must not be dropped.
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.pending_updates.push(std::move(close), false);
+    }
+    WakeServiceLoop();
 
     if (state.thread.joinable()) {
         state.thread.join();
@@ -188,10 +2107,7 @@ void ShutdownBackgroundVisualizer() {
 
     state.thread_started.store(false, std::memory_order_release);
     state.running.store(false, std::memory_order_release);
-    {
-        std::lock_guard<std::mutex> lock(state.mutex);
-        state.pending_updates.clear();
-    }
+    DiscardPendingUpdates();
 }
 
 bool IsBackgroundVisualizerRunning() {
@@ -199,91 +2115,278 @@ bool IsBackgroundVisualizerRunning() {
     return state.running.load(std::memory_order_acquire);
 }
 
+void ShowBackgroundVisualizerWindow() {
+    GetState().window_requested.store(true, std::memory_order_release);
+}
+
+uint64_t DroppedUpdateCount() {
+    return GetState().dropped_updates.load(std::memory_order_relaxed);
+}
+
+VisualizerStats GetVisualizerStats() {
+    ServiceState& state = GetState();
+    VisualizerStats stats;
+    {
+        std::lock_guard<std::mutex> lock(state.stats_mutex);
+        stats = state.stats;
+    }
+    stats.running = state.running.load(std::memory_order_acquire);
+    stats.dropped_updates = state.dropped_updates.load(std::memory_order_relaxed);
+    return stats;
+}
+
+TabHandle register_tab(const std::string& tab_id) {
+    TabHandle handle;
+    handle.id = InternName(tab_id);
+    return handle;
+}
+
+Key register_value(const std::string& tab_id, const std::string& key) {
+    return register_value(register_tab(tab_id), key);
+}
+
+Key register_value(TabHandle tab, const std::string& key) {
+    if (!tab.valid()) {
+        return Key{};
+    }
+    return RegisterKey(tab.id, key, false, GraphConfig{});
+}
+
+Key register_graph(const std::string& tab_id, const std::string& key, const GraphConfig& config) {
+    return register_graph(register_tab(tab_id), key, config);
+}
+
+Key register_graph(TabHandle tab, const std::string& key, const GraphConfig& config) {
+    if (!tab.valid()) {
+        return Key{};
+    }
+    return RegisterKey(tab.id, key, true, config);
+}
+
+void value(Key key, int value) {
+    PostKeyedValue(key, static_cast<int64_t>(value));
+}
+
+void value(Key key, int64_t value) {
+    PostKeyedValue(key, value);
+}
+
+void value(Key key, float value) {
+    PostKeyedValue(key, static_cast<double>(value));
+}
+
+void value(Key key, double value) {
+    PostKeyedValue(key, value);
+}
+
+void value(Key key, bool value) {
+    PostKeyedValue(key, value);
+}
+
+void value(Key key, std::string value) {
+    PostKeyedValue(key, std::move(value));
+}
+
+void value(Key key, const char* value) {
+    PostKeyedValue(key, std::string(value));
+}
+
+void graph_sample(Key key, float sample) {
+    if (!key.valid()) {
+        return;
+    }
+    UpdateRecord update;
+    update.op = UpdateOp::kKeyedGraphSample;
+    update.key = key.id;
+    update.sample = sample;
+    PostUpdate(std::move(update));
+}
+
 void value(const std::string& tab_id, const std::string& key, int value) {
-    PostUpdate([tab_id, key, value](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.update_value(key, value);
-    });
+    PostValue(tab_id, key, static_cast<int64_t>(value));
 }
 
 void value(const std::string& tab_id, const std::string& key, int64_t value) {
-    PostUpdate([tab_id, key, value](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.update_value(key, value);
-    });
+    PostValue(tab_id, key, value);
 }
 
 void value(const std::string& tab_id, const std::string& key, float value) {
-    PostUpdate([tab_id, key, value](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.update_value(key, value);
-    });
+    PostValue(tab_id, key, static_cast<double>(value));
 }
 
 void value(const std::string& tab_id, const std::string& key, double value) {
-    PostUpdate([tab_id, key, value](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.update_value(key, value);
-    });
+    PostValue(tab_id, key, value);
 }
 
 void value(const std::string& tab_id, const std::string& key, bool value) {
-    PostUpdate([tab_id, key, value](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.update_value(key, value);
-    });
+    PostValue(tab_id, key, value);
 }
 
 void value(const std::string& tab_id, const std::string& key, std::string value) {
-    PostUpdate([tab_id, key, value = std::move(value)](DebugVisualizerApp& app) mutable {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.update_value(key, std::move(value));
-    });
+    PostValue(tab_id, key, std::move(value));
 }
 
 void value(const std::string& tab_id, const std::string& key, const char* value) {
-    PostUpdate([tab_id, key, value = std::string(value)](DebugVisualizerApp& app) mutable {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.update_value(key, std::move(value));
-    });
+    PostValue(tab_id, key, std::string(value));
 }
 
 void graph_sample(const std::string& tab_id, const std::string& key, float sample, const GraphConfig& config) {
-    PostUpdate([tab_id, key, sample, config](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        DebugVisualizer::Graph& graph = tab.Graph.add(key, config);
-        graph.x = sample;
-    });
+    UpdateRecord update;
+    update.op = UpdateOp::kGraphSample;
+    update.tab = InternName(tab_id);
+    update.key = InternName(key);
+    update.sample = sample;
+    update.config = InternGraphConfig(config);
+    if (update.config == kUninternedGraphConfig) {
+        update.extra().config = config;
+    }
+    PostUpdate(std::move(update));
 }
 
 void graph_samples(const std::string& tab_id,
                    const std::string& key,
                    const std::vector<float>& samples,
                    const GraphConfig& config) {
-    PostUpdate([tab_id, key, samples = std::vector<float>(samples), config](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.add_graph_samples(key, samples, config);
-    });
+    UpdateRecord update;
+    update.op = UpdateOp::kGraphSamples;
+    update.tab = InternName(tab_id);
+    update.key = InternName(key);
+    update.extra().config = config;
+    update.payload->samples = samples;
+    PostUpdate(std::move(update));
 }
 
-void structure(const std::string& tab_id,
-               const std::string& key,
-               const std::function<void(StructureBuilder&)>& builder) {
-    PostUpdate([tab_id, key, builder](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.update_structure(key, builder);
-    });
+void graph_samples(const std::string& tab_id,
+                   const std::string& key,
+                   const float* samples,
+                   size_t count,
+                   const GraphConfig& config) {
+    UpdateRecord update;
+    update.op = UpdateOp::kGraphSamples;
+    update.tab = InternName(tab_id);
+    update.key = InternName(key);
+    update.extra().config = config;
+    update.payload->samples.assign(samples, samples + count);
+    PostUpdate(std::move(update));
+}
+
+void graph_samples(const std::string& tab_id,
+                   const std::string& key,
+                   std::vector<float>&& samples,
+                   const GraphConfig& config) {
+    UpdateRecord update;
+    update.op = UpdateOp::kGraphSamples;
+    update.tab = InternName(tab_id);
+    update.key = InternName(key);
+    update.extra().config = config;
+    update.payload->samples = std::move(samples);
+    PostUpdate(std::move(update));
+}
+
+void configure_series(const std::string& tab_id, const std::string& key, const TimeSeriesConfig& config) {
+    UpdateRecord update;
+    update.op = UpdateOp::kSeriesConfig;
+    update.tab = InternName(tab_id);
+    update.key = InternName(key);
+    update.extra().series_config = std::make_shared<const TimeSeriesConfig>(config);
+    PostUpdate(std::move(update));
+}
+
+void series_sample(const std::string& tab_id, const std::string& key, const float* values, size_t count) {
+    UpdateRecord update;
+    update.op = UpdateOp::kSeriesSample;
+    update.tab = InternName(tab_id);
+    update.key = InternName(key);
+    update.extra().time = SteadySeconds();
+    update.payload->samples.assign(values, values + count);
+    PostUpdate(std::move(update));
+}
+
+void series_sample(const std::string& tab_id, const std::string& key, std::initializer_list<float> values) {
+    series_sample(tab_id, key, values.begin(), values.size());
+}
+
+Counter::Counter(const std::string& tab_id, const std::string& key) : shards_(new Shard[kShards]) {
+    // add() never posts, so nothing else would start the service.
+    EnsureThreadStarted();
+    MetricEntry entry;
+    entry.key = register_value(tab_id, key);
+    entry.counter = shards_;
+    RegisterMetric(std::move(entry));
+}
+
+int64_t Counter::value() const {
+    int64_t total = 0;
+    for (size_t shard = 0; shards_ && shard < kShards; ++shard) {
+        total += shards_[shard].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Gauge::Gauge(const std::string& tab_id, const std::string& key) : cell_(std::make_shared<Cell>()) {
+    // See Counter::Counter().
+    EnsureThreadStarted();
+    MetricEntry entry;
+    entry.key = register_value(tab_id, key);
+    entry.gauge = cell_;
+    RegisterMetric(std::move(entry));
+}
+
+TabReader::TabReader(const std::string& tab_id) : slot_(std::make_shared<Slot>()) {
+    SnapshotEntry entry;
+    entry.tab = InternName(tab_id);
+    entry.slot = slot_;
+    ServiceState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.snapshots_mutex);
+    state.snapshots.push_back(std::move(entry));
+}
+
+void histogram(const std::string& tab_id, const std::string& key, double value, const HistogramConfig& config) {
+    LocalHistogramBuffer().add(InternName(tab_id), InternName(key), value, config);
+}
+
+void flush_histograms() {
+    LocalHistogramBuffer().flush();
+}
+
+ZoneSite::ZoneSite(const char* name) : id(InternName(name)) {}
+
+ScopedZone::ScopedZone(const ZoneSite& site) : site_(site.id) {
+    LocalZoneBuffer().begin();
+    begin_ns_ = SteadyNanoseconds();
+}
+
+ScopedZone::~ScopedZone() {
+    const int64_t end_ns = SteadyNanoseconds();
+    LocalZoneBuffer().end(site_, begin_ns_, end_ns);
+}
+
+void flush_zones() {
+    LocalZoneBuffer().post();
+}
+
+void structure(const std::string& tab_id, const std::string& key, std::function<void(StructureBuilder&)> builder) {
+    UpdateRecord update;
+    update.op = UpdateOp::kStructure;
+    update.tab = InternName(tab_id);
+    update.key = InternName(key);
+    update.extra().custom = [tab = update.tab, key = update.key,
+                             builder = std::move(builder)](DebugVisualizerApp& app) mutable {
+        DebugVisualizer::Tab& target = EnsureTab(app, NameOf(tab));
+        target.defer_structure(NameOf(key), std::move(builder));
+    };
+    PostUpdate(std::move(update));
 }
 
 void clear_tab(const std::string& tab_id) {
-    PostUpdate([tab_id](DebugVisualizerApp& app) {
-        DebugVisualizer::Tab& tab = EnsureTab(app, tab_id);
-        tab.clear();
-    });
+    UpdateRecord update;
+    update.op = UpdateOp::kClearTab;
+    update.tab = InternName(tab_id);
+    PostUpdate(std::move(update));
 }
 
 void set_window_title(std::string title) {
-    PostUpdate([title = std::move(title)](DebugVisualizerApp& app) mutable {
+    PostCustom([title = std::move(title)](DebugVisualizerApp& app) mutable {
         ServiceState& state = GetState();
         DebugVisualizer& tile = app.Tiles[state.tile_id];
         tile.set_window_title(title);
@@ -291,7 +2394,7 @@ void set_window_title(std::string title) {
 }
 
 void show_window(bool visible) {
-    PostUpdate([visible](DebugVisualizerApp& app) {
+    PostCustom([visible](DebugVisualizerApp& app) {
         ServiceState& state = GetState();
         DebugVisualizer& tile = app.Tiles[state.tile_id];
         tile.set_visible(visible);
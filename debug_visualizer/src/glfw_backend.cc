@@ -0,0 +1,201 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <imgui/imgui.h>
+#ifndef IMGUI_IMPL_OPENGL_LOADER_GLEW
+#define IMGUI_IMPL_OPENGL_LOADER_GLEW
+#endif
+#include <imgui/imgui_impl_glfw.h>
+#include <imgui/imgui_impl_opengl3.h>
+
+#include "debug_visualizer/src/app_backend.h"
+
+namespace dbgvis {
+namespace {
+void GlfwErrorCallback(int error, const char* description) {
+    std::fprintf(stderr, "GLFW Error (%d): %s\n", error, description);
+}
+
+void GlfwKeyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/) {
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+    }
+}
+
+class GlfwBackend : public AppBackend {
+public:
+    ~GlfwBackend() override {
+        Shutdown();
+    }
+
+    bool Initialize(const DebugVisualizerAppOptions& options) override;
+    void Shutdown() override;
+
+    bool Renders() const override {
+        return true;
+    }
+
+    bool ShouldClose() const override {
+        return !window || glfwWindowShouldClose(window) != GLFW_FALSE;
+    }
+
+    void RequestClose() override {
+        if (window) {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+    }
+
+    void PollEvents() override {
+        glfwPollEvents();
+    }
+
+    void WaitEvents(double timeout) override {
+        glfwWaitEventsTimeout(timeout);
+    }
+
+    void Wake() override {
+        glfwPostEmptyEvent();
+    }
+
+    double Time() const override {
+        return glfwGetTime();
+    }
+
+    void NewFrame() override {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+    }
+
+    void Present(ImDrawData* draw_data) override;
+
+    void SetTitle(const std::string& title) override {
+        if (window) {
+            glfwSetWindowTitle(window, title.c_str());
+        }
+    }
+
+private:
+    GLFWwindow* window = nullptr;
+    bool glfw_initialized = false;
+    bool imgui_initialized = false;
+};
+
+bool GlfwBackend::Initialize(const DebugVisualizerAppOptions& options) {
+    glfwSetErrorCallback(GlfwErrorCallback);
+    if (!glfwInit()) {
+        std::fprintf(stderr, "Failed to initialize GLFW\n");
+        return false;
+    }
+    glfw_initialized = true;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, options.gl_context_major_version);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, options.gl_context_minor_version);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    window = glfwCreateWindow(options.width, options.height, options.window_title.c_str(), nullptr, nullptr);
+    if (!window) {
+        std::fprintf(stderr, "Failed to create GLFW window\n");
+        Shutdown();
+        return false;
+    }
+
+    glfwSetKeyCallback(window, GlfwKeyCallback);
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(options.vsync ? 1 : 0);
+
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        std::fprintf(stderr, "Failed to initialize GLEW\n");
+        Shutdown();
+        return false;
+    }
+
+    glGetError();  // Clear spurious error from GLEW initialization.
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    if (options.enable_keyboard_navigation) {
+        io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+    }
+    if (options.enable_docking) {
+#ifdef ImGuiConfigFlags_DockingEnable
+        io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+#endif
+    }
+
+    ImGui::StyleColorsDark();
+
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init(options.glsl_version.c_str());
+    imgui_initialized = true;
+    return true;
+}
+
+void GlfwBackend::Shutdown() {
+    if (imgui_initialized) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+        imgui_initialized = false;
+    }
+
+    if (window) {
+        glfwDestroyWindow(window);
+        window = nullptr;
+    }
+
+    if (glfw_initialized) {
+        glfwTerminate();
+        glfw_initialized = false;
+    }
+}
+
+void GlfwBackend::Present(ImDrawData* draw_data) {
+    int display_w = 0;
+    int display_h = 0;
+    glfwGetFramebufferSize(window, &display_w, &display_h);
+    glViewport(0, 0, display_w, display_h);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+
+    glfwSwapBuffers(window);
+}
+
+std::unique_ptr<AppBackend> CreateGlfwBackend() {
+    return std::make_unique<GlfwBackend>();
+}
+
+const bool kGlfwBackendRegistered = RegisterWindowedBackend(&CreateGlfwBackend);
+}  // namespace
+}  // namespace dbgvis
@@ -0,0 +1,96 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "debug_visualizer/src/app_backend.h"
+
+namespace dbgvis {
+namespace {
+class HeadlessBackend : public AppBackend {
+public:
+    bool Initialize(const DebugVisualizerAppOptions& options) override {
+        const float hz = std::max(options.headless_update_hz, 1.0f);
+        tick_ = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.0f / hz));
+        start_ = Clock::now();
+        next_tick_ = start_;
+        close_requested_.store(false, std::memory_order_release);
+        return true;
+    }
+
+    void Shutdown() override {}
+
+    bool Renders() const override {
+        return false;
+    }
+
+    bool ShouldClose() const override {
+        return close_requested_.load(std::memory_order_acquire);
+    }
+
+    void RequestClose() override {
+        close_requested_.store(true, std::memory_order_release);
+    }
+
+    void PollEvents() override {
+        next_tick_ += tick_;
+        const auto now = Clock::now();
+        if (next_tick_ < now) {
+            next_tick_ = now;
+        }
+        std::this_thread::sleep_until(next_tick_);
+    }
+
+    // Nothing is drawn, so there is no frame to skip; keep the fixed tick.
+    void WaitEvents(double /*timeout*/) override {
+        PollEvents();
+    }
+
+    void Wake() override {}
+
+    double Time() const override {
+        return std::chrono::duration<double>(Clock::now() - start_).count();
+    }
+
+    void NewFrame() override {}
+    void Present(ImDrawData* /*draw_data*/) override {}
+    void SetTitle(const std::string& /*title*/) override {}
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration tick_{};
+    Clock::time_point start_;
+    Clock::time_point next_tick_;
+    std::atomic<bool> close_requested_{false};
+};
+}  // namespace
+
+std::unique_ptr<AppBackend> CreateHeadlessBackend() {
+    return std::make_unique<HeadlessBackend>();
+}
+
+}  // namespace dbgvis
@@ -33,12 +33,17 @@ constexpr int kCounterModulo = kMaxCounterValue + 1;
 }  // namespace
 
 int main() {
+    if (!DBGVIS_ENABLED) {
+        return 0;
+    }
+
     dbgvis::StartBackgroundVisualizer();
     dbgvis::set_window_title("Debug Window");
 
-    while (!dbgvis::IsBackgroundVisualizerRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
+    dbgvis::TimeSeriesConfig timing_series;
+    timing_series.series = {"frame time (ms)", "budget (ms)"};
+    timing_series.time_window = 5.0;
+    dbgvis::configure_series("Telemetry", "Timing/Frame time", timing_series);
 
     int counter = 0;
     uint64_t wraps = 0;
@@ -46,6 +51,7 @@ int main() {
     auto last_frame_time = start_time;
 
     while (dbgvis::IsBackgroundVisualizerRunning()) {
+        DBGVIS_SCOPE("Frame");
         const auto now = std::chrono::steady_clock::now();
         const std::chrono::duration<float> elapsed = now - start_time;
         const std::chrono::duration<float> delta = now - last_frame_time;
@@ -77,6 +83,8 @@ int main() {
         dbgvis::value("Telemetry", "Timing/Budget used", budget_used);
 
         dbgvis::graph_sample("Telemetry", "Counter Value", static_cast<float>(counter));
+        dbgvis::series_sample("Telemetry", "Timing/Frame time", {frame_time_ms, kTargetFrameTimeMs});
+        dbgvis::histogram("Telemetry", "Timing/Frame time distribution (ms)", frame_time_ms);
 
         dbgvis::structure("Telemetry", "Counter/Progress", [counter, remaining, wraps](dbgvis::StructureBuilder& builder) {
             builder.field("current", counter);
@@ -84,7 +92,10 @@ int main() {
             builder.field("remaining_to_wrap", remaining);
         });
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        {
+            DBGVIS_SCOPE("Sleep");
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        }
     }
     dbgvis::ShutdownBackgroundVisualizer();
     return 0;
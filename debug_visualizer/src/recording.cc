@@ -0,0 +1,1050 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#include "debug_visualizer/recording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "debug_visualizer/src/recording_format.h"
+
+namespace dbgvis {
+namespace recording {
+namespace {
+// Deeper trees are treated as corruption rather than risking the stack.
+constexpr int kMaxNodeDepth = 256;
+
+uint64_t NowMicros() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+uint64_t PackKey(uint64_t tab, uint64_t key) {
+    return (tab << 32) | key;
+}
+
+bool SameConfig(const GraphConfig& a, const GraphConfig& b) {
+    return a.max_samples == b.max_samples && a.auto_scale == b.auto_scale && a.manual_min == b.manual_min &&
+           a.manual_max == b.manual_max && a.level_of_detail == b.level_of_detail;
+}
+
+void WriteGraphConfig(ByteWriter& out, uint32_t tab, uint32_t key, const GraphConfig& config) {
+    out.u8(static_cast<uint8_t>(Tag::kGraphConfig));
+    out.varint(tab);
+    out.varint(key);
+    out.varint(config.max_samples);
+    out.u8(static_cast<uint8_t>((config.auto_scale ? kGraphAutoScale : 0) |
+                                (config.level_of_detail ? kGraphLevelOfDetail : 0)));
+    out.f32(config.manual_min);
+    out.f32(config.manual_max);
+}
+void WriteSeriesConfig(ByteWriter& out, uint32_t tab, uint32_t key, const TimeSeriesConfig& config) {
+    out.u8(static_cast<uint8_t>(Tag::kSeriesConfig));
+    out.varint(tab);
+    out.varint(key);
+    out.varint(config.max_samples);
+    out.u8(config.auto_scale ? kGraphAutoScale : 0);
+    out.f32(config.manual_min);
+    out.f32(config.manual_max);
+    out.f64(config.time_window);
+    out.varint(config.series.size());
+    for (const auto& label : config.series) {
+        out.string(label);
+    }
+}
+
+void WriteHistogram(ByteWriter& out, uint32_t tab, uint32_t key, const QuantileSketch& sketch) {
+    out.u8(static_cast<uint8_t>(Tag::kHistogram));
+    out.varint(tab);
+    out.varint(key);
+    const HistogramConfig& config = sketch.config();
+    out.f64(config.relative_accuracy);
+    out.f64(config.min_value);
+    out.f64(config.max_value);
+    out.varint(sketch.zero_count());
+    out.f64(sketch.sum());
+    out.f64(sketch.min());
+    out.f64(sketch.max());
+    out.zigzag(sketch.first_index());
+    out.varint(sketch.counts().size());
+    for (uint64_t count : sketch.counts()) {
+        out.varint(count);
+    }
+}
+
+void EmitNode(StructureBuilder& builder, const StructureNode& node) {
+    if (node.value.has_value()) {
+        std::visit(
+            [&](const auto& v) {
+                builder.field(node.label, v);
+            },
+            *node.value);
+        return;
+    }
+    StructureBuilder nested = builder.nested(node.label);
+    for (const auto& child : node.children) {
+        EmitNode(nested, child);
+    }
+}
+}  // namespace
+
+void ByteWriter::scalar(const ScalarValue& value) {
+    std::visit(
+        [&](const auto& v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, int64_t>) {
+                u8(static_cast<uint8_t>(ValueKind::kInt));
+                zigzag(v);
+            } else if constexpr (std::is_same_v<T, double>) {
+                u8(static_cast<uint8_t>(ValueKind::kDouble));
+                f64(v);
+            } else if constexpr (std::is_same_v<T, bool>) {
+                u8(static_cast<uint8_t>(ValueKind::kBool));
+                u8(v ? 1 : 0);
+            } else {
+                u8(static_cast<uint8_t>(ValueKind::kString));
+                string(v);
+            }
+        },
+        value);
+}
+
+void ByteWriter::node(const StructureNode& node) {
+    string(node.label);
+    if (node.value.has_value()) {
+        scalar(*node.value);
+    } else {
+        u8(static_cast<uint8_t>(ValueKind::kNone));
+    }
+    varint(node.children.size());
+    for (const auto& child : node.children) {
+        this->node(child);
+    }
+}
+
+std::optional<ScalarValue> ByteReader::scalar() {
+    switch (static_cast<ValueKind>(u8())) {
+        case ValueKind::kNone:
+            return std::nullopt;
+        case ValueKind::kInt:
+            return ScalarValue{zigzag()};
+        case ValueKind::kDouble:
+            return ScalarValue{f64()};
+        case ValueKind::kBool:
+            return ScalarValue{u8() != 0};
+        case ValueKind::kString:
+            return ScalarValue{std::string(string())};
+    }
+    ok_ = false;
+    return std::nullopt;
+}
+
+StructureNode ByteReader::node(int depth) {
+    StructureNode result;
+    if (depth > kMaxNodeDepth) {
+        ok_ = false;
+        return result;
+    }
+    result.label = std::string(string());
+    result.value = scalar();
+    const uint64_t children = varint();
+    for (uint64_t i = 0; i < children && ok_; ++i) {
+        result.children.push_back(node(depth + 1));
+    }
+    return result;
+}
+
+void WriteHeader(ByteWriter& out, const std::string& tile_id) {
+    out.raw(kMagic, sizeof(kMagic));
+    for (int i = 0; i < 4; ++i) {
+        out.u8(static_cast<uint8_t>(kVersion >> (8 * i)));
+    }
+    out.string(tile_id);
+}
+
+bool ReadHeader(ByteReader& in, std::string& tile_id) {
+    char magic[sizeof(kMagic)];
+    for (char& c : magic) {
+        c = static_cast<char>(in.u8());
+    }
+    uint32_t version = 0;
+    for (int i = 0; i < 4; ++i) {
+        version |= static_cast<uint32_t>(in.u8()) << (8 * i);
+    }
+    tile_id = std::string(in.string());
+    return in.ok() && std::memcmp(magic, kMagic, sizeof(magic)) == 0 && version == kVersion;
+}
+
+void Encoder::reset() {
+    start_us_ = NowMicros();
+    last_frame_us_ = 0;
+    frames_ = 0;
+    frame_open_ = false;
+    frame_begin_ = 0;
+    out_.clear();
+    name_ids_.clear();
+    names_.clear();
+    graph_configs_.clear();
+}
+
+void Encoder::open_frame() {
+    if (!frame_open_) {
+        const uint64_t now = NowMicros() - start_us_;
+        frame_begin_ = out_.size();
+        out_.u8(static_cast<uint8_t>(Tag::kFrame));
+        out_.varint(now - last_frame_us_);
+        last_frame_us_ = now;
+        frame_open_ = true;
+    }
+}
+
+void Encoder::end_frame() {
+    if (frame_open_) {
+        frame_open_ = false;
+        ++frames_;
+    }
+}
+
+void Encoder::discard_frame() {
+    if (frame_open_) {
+        out_.truncate(frame_begin_);
+        frame_open_ = false;
+    }
+}
+
+uint32_t Encoder::name_id(const std::string& name) {
+    auto [it, inserted] = name_ids_.try_emplace(name, static_cast<uint32_t>(names_.size()));
+    if (inserted) {
+        names_.push_back(name);
+        out_.u8(static_cast<uint8_t>(Tag::kName));
+        out_.varint(it->second);
+        out_.string(name);
+    }
+    return it->second;
+}
+
+void Encoder::value(const std::string& tab, const std::string& key, const ScalarValue& value) {
+    open_frame();
+    const uint32_t tab_id = name_id(tab);
+    const uint32_t key_id = name_id(key);
+    out_.u8(static_cast<uint8_t>(Tag::kValue));
+    out_.varint(tab_id);
+    out_.varint(key_id);
+    out_.scalar(value);
+}
+
+void Encoder::graph_config(uint32_t tab, uint32_t key, const GraphConfig& config) {
+    auto [it, inserted] = graph_configs_.try_emplace(PackKey(tab, key), config);
+    if (!inserted && SameConfig(it->second, config)) {
+        return;
+    }
+    it->second = config;
+    WriteGraphConfig(out_, tab, key, config);
+}
+
+void Encoder::graph_sample(const std::string& tab, const std::string& key, const GraphConfig& config, float sample) {
+    open_frame();
+    const uint32_t tab_id = name_id(tab);
+    const uint32_t key_id = name_id(key);
+    graph_config(tab_id, key_id, config);
+    out_.u8(static_cast<uint8_t>(Tag::kGraphSample));
+    out_.varint(tab_id);
+    out_.varint(key_id);
+    out_.f32(sample);
+}
+
+void Encoder::graph_samples(const std::string& tab,
+                            const std::string& key,
+                            const GraphConfig& config,
+                            const std::vector<float>& samples) {
+    open_frame();
+    const uint32_t tab_id = name_id(tab);
+    const uint32_t key_id = name_id(key);
+    graph_config(tab_id, key_id, config);
+    out_.u8(static_cast<uint8_t>(Tag::kGraphSamples));
+    out_.varint(tab_id);
+    out_.varint(key_id);
+    out_.varint(samples.size());
+    for (float sample : samples) {
+        out_.f32(sample);
+    }
+}
+
+void Encoder::series_config(const std::string& tab, const std::string& key, const TimeSeriesConfig& config) {
+    open_frame();
+    WriteSeriesConfig(out_, name_id(tab), name_id(key), config);
+}
+
+void Encoder::series_sample(const std::string& tab,
+                            const std::string& key,
+                            double time,
+                            const std::vector<float>& values) {
+    open_frame();
+    const uint32_t tab_id = name_id(tab);
+    const uint32_t key_id = name_id(key);
+    out_.u8(static_cast<uint8_t>(Tag::kSeriesSamples));
+    out_.varint(tab_id);
+    out_.varint(key_id);
+    out_.varint(1);
+    out_.varint(values.size());
+    out_.f64(time);
+    for (float value : values) {
+        out_.f32(value);
+    }
+}
+
+void Encoder::histogram(const std::string& tab, const std::string& key, const QuantileSketch& sketch) {
+    open_frame();
+    const uint32_t tab_id = name_id(tab);
+    const uint32_t key_id = name_id(key);
+    WriteHistogram(out_, tab_id, key_id, sketch);
+}
+
+void Encoder::structure(const std::string& tab, const std::string& key, const std::optional<StructureNode>& root) {
+    open_frame();
+    const uint32_t tab_id = name_id(tab);
+    const uint32_t key_id = name_id(key);
+    out_.u8(static_cast<uint8_t>(Tag::kStructure));
+    out_.varint(tab_id);
+    out_.varint(key_id);
+    if (!root) {
+        out_.varint(0);
+        return;
+    }
+    out_.varint(root->children.size());
+    for (const auto& child : root->children) {
+        out_.node(child);
+    }
+}
+
+void Encoder::clear_tab(const std::string& tab) {
+    open_frame();
+    const uint32_t tab_id = name_id(tab);
+    out_.u8(static_cast<uint8_t>(Tag::kClearTab));
+    out_.varint(tab_id);
+}
+
+size_t Encoder::keyframe(const DebugVisualizer& tile) {
+    struct Entry {
+        const DebugVisualizer::Tab* tab;
+        uint32_t tab_id;
+        std::vector<std::pair<std::string, uint32_t>> scalars;
+        std::vector<std::pair<std::string, uint32_t>> graphs;
+        std::vector<std::pair<std::string, uint32_t>> series;
+        std::vector<std::pair<std::string, uint32_t>> histograms;
+        std::vector<std::pair<std::string, uint32_t>> structures;
+    };
+
+    // Names first seen here are declared in the main stream too, so that
+    // readers decoding linearly, which skip keyframe bodies, know them.
+    std::vector<Entry> entries;
+    for (const auto& id : tile.tab_ids()) {
+        const DebugVisualizer::Tab* tab = tile.find_tab(id);
+        if (!tab) {
+            continue;
+        }
+        Entry entry{tab, name_id(id), {}, {}, {}, {}, {}};
+        for (auto& key : tab->scalar_keys()) {
+            const uint32_t key_id = name_id(key);
+            entry.scalars.emplace_back(std::move(key), key_id);
+        }
+        for (auto& key : tab->graph_keys()) {
+            const uint32_t key_id = name_id(key);
+            entry.graphs.emplace_back(std::move(key), key_id);
+        }
+        for (auto& key : tab->series_keys()) {
+            const uint32_t key_id = name_id(key);
+            entry.series.emplace_back(std::move(key), key_id);
+        }
+        for (auto& key : tab->histogram_keys()) {
+            const uint32_t key_id = name_id(key);
+            entry.histograms.emplace_back(std::move(key), key_id);
+        }
+        for (auto& key : tab->structure_keys()) {
+            const uint32_t key_id = name_id(key);
+            entry.structures.emplace_back(std::move(key), key_id);
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    ByteWriter& body = scratch_;
+    body.clear();
+    body.varint(frames_ == 0 ? 0 : frames_ - 1);
+    body.varint(last_frame_us_);
+    for (size_t id = 0; id < names_.size(); ++id) {
+        body.u8(static_cast<uint8_t>(Tag::kName));
+        body.varint(id);
+        body.string(names_[id]);
+    }
+
+    graph_configs_.clear();
+    for (const auto& entry : entries) {
+        for (const auto& [key, key_id] : entry.scalars) {
+            if (auto value = entry.tab->get_scalar(key)) {
+                body.u8(static_cast<uint8_t>(Tag::kValue));
+                body.varint(entry.tab_id);
+                body.varint(key_id);
+                body.scalar(*value);
+            }
+        }
+        for (const auto& [key, key_id] : entry.graphs) {
+            const DebugVisualizer::Graph* graph = entry.tab->find_graph(key);
+            if (!graph) {
+                continue;
+            }
+            graph_configs_[PackKey(entry.tab_id, key_id)] = graph->config();
+            WriteGraphConfig(body, entry.tab_id, key_id, graph->config());
+            const std::vector<float> samples = graph->samples();
+            body.u8(static_cast<uint8_t>(Tag::kGraphSamples));
+            body.varint(entry.tab_id);
+            body.varint(key_id);
+            body.varint(samples.size());
+            for (float sample : samples) {
+                body.f32(sample);
+            }
+        }
+        for (const auto& [key, key_id] : entry.series) {
+            const DebugVisualizer::TimeSeries* series = entry.tab->find_series(key);
+            if (!series) {
+                continue;
+            }
+            WriteSeriesConfig(body, entry.tab_id, key_id, series->config());
+            if (series->empty()) {
+                continue;
+            }
+            body.u8(static_cast<uint8_t>(Tag::kSeriesSamples));
+            body.varint(entry.tab_id);
+            body.varint(key_id);
+            body.varint(series->size());
+            body.varint(series->series_count());
+            for (size_t i = 0; i < series->size(); ++i) {
+                body.f64(series->time(i));
+            }
+            for (size_t column = 0; column < series->series_count(); ++column) {
+                for (size_t i = 0; i < series->size(); ++i) {
+                    body.f32(series->value(column, i));
+                }
+            }
+        }
+        for (const auto& [key, key_id] : entry.histograms) {
+            if (const QuantileSketch* sketch = entry.tab->find_histogram(key)) {
+                WriteHistogram(body, entry.tab_id, key_id, *sketch);
+            }
+        }
+        for (const auto& [key, key_id] : entry.structures) {
+            auto root = entry.tab->get_structure(key);
+            if (!root) {
+                continue;
+            }
+            body.u8(static_cast<uint8_t>(Tag::kStructure));
+            body.varint(entry.tab_id);
+            body.varint(key_id);
+            body.varint(root->children.size());
+            for (const auto& child : root->children) {
+                body.node(child);
+            }
+        }
+    }
+
+    const size_t offset = out_.size();
+    out_.u8(static_cast<uint8_t>(Tag::kKeyframe));
+    out_.varint(body.size());
+    out_.raw(body.data(), body.size());
+    return offset;
+}
+
+void Decoder::reset() {
+    names_.clear();
+    graph_configs_.clear();
+}
+
+const std::string& Decoder::name(uint64_t id) const {
+    static const std::string kUnknown = "?";
+    return id < names_.size() ? names_[id] : kUnknown;
+}
+
+bool Decoder::apply(Tag tag, ByteReader& in, DebugVisualizer* tile) {
+    switch (tag) {
+        case Tag::kName: {
+            const uint64_t id = in.varint();
+            const std::string_view text = in.string();
+            if (!in.ok() || id > names_.size() + (1u << 20)) {
+                return false;
+            }
+            if (id >= names_.size()) {
+                names_.resize(static_cast<size_t>(id) + 1);
+            }
+            names_[static_cast<size_t>(id)] = std::string(text);
+            return true;
+        }
+        case Tag::kValue: {
+            const uint64_t tab = in.varint();
+            const uint64_t key = in.varint();
+            std::optional<ScalarValue> value = in.scalar();
+            if (!in.ok() || !value) {
+                return false;
+            }
+            if (tile) {
+                DebugVisualizer::Tab& target = tile->tabs[name(tab)];
+                std::visit(
+                    [&](auto& v) {
+                        target.update_value(name(key), std::move(v));
+                    },
+                    *value);
+            }
+            return true;
+        }
+        case Tag::kGraphConfig: {
+            const uint64_t tab = in.varint();
+            const uint64_t key = in.varint();
+            GraphConfig config;
+            config.max_samples = static_cast<size_t>(in.varint());
+            const uint8_t flags = in.u8();
+            config.auto_scale = (flags & kGraphAutoScale) != 0;
+            config.level_of_detail = (flags & kGraphLevelOfDetail) != 0;
+            config.manual_min = in.f32();
+            config.manual_max = in.f32();
+            graph_configs_[PackKey(tab, key)] = config;
+            return in.ok();
+        }
+        case Tag::kGraphSample: {
+            const uint64_t tab = in.varint();
+            const uint64_t key = in.varint();
+            const float sample = in.f32();
+            if (!in.ok()) {
+                return false;
+            }
+            if (tile) {
+                auto it = graph_configs_.find(PackKey(tab, key));
+                tile->tabs[name(tab)].push_graph_sample(name(key), sample,
+                                                        it != graph_configs_.end() ? it->second : GraphConfig{});
+            }
+            return true;
+        }
+        case Tag::kGraphSamples: {
+            const uint64_t tab = in.varint();
+            const uint64_t key = in.varint();
+            const uint64_t count = in.varint();
+            samples_.clear();
+            for (uint64_t i = 0; i < count && in.ok(); ++i) {
+                samples_.push_back(in.f32());
+            }
+            if (!in.ok()) {
+                return false;
+            }
+            if (tile) {
+                auto it = graph_configs_.find(PackKey(tab, key));
+                tile->tabs[name(tab)].add_graph_samples(name(key), samples_,
+                                                        it != graph_configs_.end() ? it->second : GraphConfig{});
+            }
+            return true;
+        }
+        case Tag::kSeriesConfig: {
+            const uint64_t tab = in.varint();
+            const uint64_t key = in.varint();
+            TimeSeriesConfig config;
+            config.max_samples = static_cast<size_t>(in.varint());
+            config.auto_scale = (in.u8() & kGraphAutoScale) != 0;
+            config.manual_min = in.f32();
+            config.manual_max = in.f32();
+            config.time_window = in.f64();
+            const uint64_t count = in.varint();
+            for (uint64_t i = 0; i < count && in.ok(); ++i) {
+                config.series.emplace_back(in.string());
+            }
+            if (!in.ok()) {
+                return false;
+            }
+            if (tile) {
+                tile->tabs[name(tab)].configure_series(name(key), config);
+            }
+            return true;
+        }
+        case Tag::kSeriesSamples: {
+            const uint64_t tab = in.varint();
+            const uint64_t key = in.varint();
+            const uint64_t rows = in.varint();
+            const uint64_t columns = in.varint();
+            // Keeps rows * columns from overflowing; the reads below stop at
+            // the end of the input long before these limits.
+            if (!in.ok() || columns > (1u << 16) || rows > (1u << 26)) {
+                return false;
+            }
+            times_.clear();
+            for (uint64_t i = 0; i < rows && in.ok(); ++i) {
+                times_.push_back(in.f64());
+            }
+            samples_.clear();
+            for (uint64_t i = 0; i < rows * columns && in.ok(); ++i) {
+                samples_.push_back(in.f32());
+            }
+            if (!in.ok()) {
+                return false;
+            }
+            if (tile) {
+                DebugVisualizer::Tab& target = tile->tabs[name(tab)];
+                const std::string& series = name(key);
+                row_.resize(static_cast<size_t>(columns));
+                for (size_t i = 0; i < times_.size(); ++i) {
+                    for (size_t column = 0; column < row_.size(); ++column) {
+                        row_[column] = samples_[column * times_.size() + i];
+                    }
+                    target.push_series_sample(series, times_[i], row_.data(), row_.size());
+                }
+            }
+            return true;
+        }
+        case Tag::kHistogram: {
+            const uint64_t tab = in.varint();
+            const uint64_t key = in.varint();
+            HistogramConfig config;
+            config.relative_accuracy = in.f64();
+            config.min_value = in.f64();
+            config.max_value = in.f64();
+            const uint64_t zero_count = in.varint();
+            const double sum = in.f64();
+            const double min = in.f64();
+            const double max = in.f64();
+            const int64_t first_index = in.zigzag();
+            const uint64_t count = in.varint();
+            // restore() rejects buckets outside the config's range; this
+            // only keeps the index arithmetic in range.
+            if (!in.ok() || first_index < INT32_MIN || first_index > INT32_MAX || count > (1u << 24)) {
+                return false;
+            }
+            std::vector<uint64_t> counts;
+            for (uint64_t i = 0; i < count && in.ok(); ++i) {
+                counts.push_back(in.varint());
+            }
+            QuantileSketch sketch(config);
+            if (!in.ok() || !sketch.restore(zero_count, static_cast<int32_t>(first_index), std::move(counts), sum,
+                                            min, max)) {
+                return false;
+            }
+            if (tile) {
+                tile->tabs[name(tab)].merge_histogram(name(key), sketch);
+            }
+            return true;
+        }
+        case Tag::kStructure: {
+            const uint64_t tab = in.varint();
+            const uint64_t key = in.varint();
+            const uint64_t children = in.varint();
+            StructureNode root;
+            for (uint64_t i = 0; i < children && in.ok(); ++i) {
+                root.children.push_back(in.node());
+            }
+            if (!in.ok()) {
+                return false;
+            }
+            if (tile) {
+                tile->tabs[name(tab)].update_structure(name(key), [&root](StructureBuilder& builder) {
+                    for (const auto& child : root.children) {
+                        EmitNode(builder, child);
+                    }
+                });
+            }
+            return true;
+        }
+        case Tag::kClearTab: {
+            const uint64_t tab = in.varint();
+            if (!in.ok()) {
+                return false;
+            }
+            if (tile) {
+                tile->tabs[name(tab)].clear();
+            }
+            return true;
+        }
+        case Tag::kFrame:
+        case Tag::kKeyframe:
+        case Tag::kIndex:
+            break;
+    }
+    return false;
+}
+
+bool Decoder::keyframe(ByteReader& in, DebugVisualizer& tile) {
+    tile.clear();
+    reset();
+    while (!in.at_end()) {
+        if (!apply(static_cast<Tag>(in.u8()), in, &tile)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Recorder::~Recorder() {
+    close();
+}
+
+bool Recorder::open(const std::string& path, const std::string& tile_id, size_t keyframe_interval) {
+    close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+
+    ByteWriter header;
+    WriteHeader(header, tile_id);
+
+    offset_ = 0;
+    keyframe_interval_ = std::max<size_t>(keyframe_interval, 1);
+    frames_since_keyframe_ = 0;
+    encoder_.reset();
+    index_.clear();
+    write(header);
+    return true;
+}
+
+void Recorder::close() {
+    if (!file_) {
+        return;
+    }
+    encoder_.end_frame();
+    write(encoder_.bytes());
+    encoder_.clear_bytes();
+
+    const uint64_t index_offset = offset_;
+    ByteWriter footer;
+    footer.u8(static_cast<uint8_t>(Tag::kIndex));
+    footer.varint(index_.size());
+    for (const auto& entry : index_) {
+        footer.varint(entry.frame);
+        footer.varint(entry.time_us);
+        footer.varint(entry.offset);
+    }
+    footer.fixed64(encoder_.frames());
+    footer.fixed64(encoder_.time_us());
+    footer.fixed64(index_offset);
+    footer.raw(kIndexMagic, sizeof(kIndexMagic));
+    write(footer);
+
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+bool Recorder::is_open() const {
+    return file_ != nullptr;
+}
+
+void Recorder::end_frame(const DebugVisualizer& tile) {
+    if (!file_ || !encoder_.frame_open()) {
+        return;
+    }
+    encoder_.end_frame();
+    ++frames_since_keyframe_;
+    const bool keyframe = encoder_.frames() == 1 || frames_since_keyframe_ >= keyframe_interval_;
+    if (keyframe) {
+        const size_t position = encoder_.keyframe(tile);
+        index_.push_back(IndexEntry{encoder_.frames() - 1, encoder_.time_us(), offset_ + position});
+        frames_since_keyframe_ = 0;
+    }
+    write(encoder_.bytes());
+    encoder_.clear_bytes();
+    if (keyframe) {
+        std::fflush(file_);
+    }
+}
+
+void Recorder::write(const ByteWriter& bytes) {
+    if (!file_ || bytes.size() == 0) {
+        return;
+    }
+    std::fwrite(bytes.data(), 1, bytes.size(), file_);
+    offset_ += bytes.size();
+}
+
+}  // namespace recording
+
+namespace {
+using recording::ByteReader;
+using recording::IndexEntry;
+using recording::Tag;
+}  // namespace
+
+struct RecordingReader::Impl {
+    ~Impl() {
+        if (data) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+    }
+
+    bool Load();
+    void Scan();
+    void Rewind();
+    bool LoadKeyframe(const IndexEntry& entry, DebugVisualizer& tile);
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t records_begin = 0;
+    size_t records_end = 0;
+    std::string tile_id;
+    std::vector<IndexEntry> keyframes;
+    uint64_t frame_count = 0;
+    uint64_t duration_us = 0;
+
+    recording::Decoder decoder;
+    size_t cursor = 0;
+    uint64_t next_frame = 0;
+    uint64_t time_us = 0;
+    // Tile the decoder state belongs to; stepping forward only continues it.
+    const DebugVisualizer* tile = nullptr;
+    bool positioned = false;
+};
+
+bool RecordingReader::Impl::Load() {
+    ByteReader header(data, data + size);
+    if (!recording::ReadHeader(header, tile_id)) {
+        return false;
+    }
+    records_begin = static_cast<size_t>(header.position() - data);
+    records_end = size;
+
+    if (size >= records_begin + recording::kTrailerSize &&
+        std::memcmp(data + size - sizeof(recording::kIndexMagic), recording::kIndexMagic,
+                    sizeof(recording::kIndexMagic)) == 0) {
+        ByteReader trailer(data + size - recording::kTrailerSize, data + size);
+        const uint64_t frames = trailer.fixed64();
+        const uint64_t duration = trailer.fixed64();
+        const uint64_t index_offset = trailer.fixed64();
+        if (index_offset >= records_begin && index_offset < size - recording::kTrailerSize) {
+            ByteReader index(data + index_offset, data + size - recording::kTrailerSize);
+            if (static_cast<Tag>(index.u8()) == Tag::kIndex) {
+                const uint64_t count = index.varint();
+                std::vector<IndexEntry> entries;
+                for (uint64_t i = 0; i < count && index.ok(); ++i) {
+                    IndexEntry entry;
+                    entry.frame = index.varint();
+                    entry.time_us = index.varint();
+                    entry.offset = index.varint();
+                    entries.push_back(entry);
+                }
+                if (index.ok()) {
+                    keyframes = std::move(entries);
+                    frame_count = frames;
+                    duration_us = duration;
+                    records_end = static_cast<size_t>(index_offset);
+                    return true;
+                }
+            }
+        }
+    }
+
+    Scan();
+    return true;
+}
+
+void RecordingReader::Impl::Scan() {
+    keyframes.clear();
+    frame_count = 0;
+    uint64_t time = 0;
+    ByteReader in(data + records_begin, data + size);
+    const uint8_t* record = in.position();
+    while (!in.at_end()) {
+        record = in.position();
+        const Tag tag = static_cast<Tag>(in.u8());
+        if (tag == Tag::kFrame) {
+            time += in.varint();
+            if (!in.ok()) {
+                break;
+            }
+            ++frame_count;
+        } else if (tag == Tag::kKeyframe) {
+            const uint64_t body_size = in.varint();
+            ByteReader body(in.position(), in.position() + std::min<uint64_t>(body_size, data + size - in.position()));
+            IndexEntry entry;
+            entry.frame = body.varint();
+            entry.time_us = body.varint();
+            entry.offset = static_cast<uint64_t>(record - data);
+            in.skip(body_size);
+            if (!in.ok()) {
+                break;
+            }
+            keyframes.push_back(entry);
+        } else if (tag == Tag::kIndex || !decoder.apply(tag, in, nullptr) || !in.ok()) {
+            break;
+        }
+        record = in.position();
+    }
+    // A recording cut short ends at the last complete record.
+    records_end = static_cast<size_t>(record - data);
+    duration_us = time;
+    Rewind();
+}
+
+void RecordingReader::Impl::Rewind() {
+    decoder.reset();
+    cursor = records_begin;
+    next_frame = 0;
+    time_us = 0;
+    positioned = true;
+}
+
+bool RecordingReader::Impl::LoadKeyframe(const IndexEntry& entry, DebugVisualizer& tile) {
+    if (entry.offset < records_begin || entry.offset >= records_end) {
+        return false;
+    }
+    ByteReader in(data + entry.offset, data + records_end);
+    if (static_cast<Tag>(in.u8()) != Tag::kKeyframe) {
+        return false;
+    }
+    const uint64_t body_size = in.varint();
+    if (!in.ok() || body_size > static_cast<uint64_t>(data + records_end - in.position())) {
+        return false;
+    }
+    const uint8_t* body_end = in.position() + body_size;
+    ByteReader body(in.position(), body_end);
+    const uint64_t frame = body.varint();
+    const uint64_t time = body.varint();
+
+    if (!decoder.keyframe(body, tile)) {
+        positioned = false;
+        return false;
+    }
+
+    cursor = static_cast<size_t>(body_end - data);
+    next_frame = frame + 1;
+    time_us = time;
+    positioned = true;
+    return true;
+}
+
+RecordingReader::RecordingReader() : impl_(std::make_unique<Impl>()) {}
+
+RecordingReader::~RecordingReader() = default;
+
+std::unique_ptr<RecordingReader> RecordingReader::open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<RecordingReader> reader(new RecordingReader());
+    reader->impl_->data = static_cast<const uint8_t*>(mapped);
+    reader->impl_->size = static_cast<size_t>(info.st_size);
+    if (!reader->impl_->Load()) {
+        return nullptr;
+    }
+    reader->impl_->Rewind();
+    return reader;
+}
+
+const std::string& RecordingReader::tile_id() const {
+    return impl_->tile_id;
+}
+
+uint64_t RecordingReader::frame_count() const {
+    return impl_->frame_count;
+}
+
+uint64_t RecordingReader::keyframe_count() const {
+    return impl_->keyframes.size();
+}
+
+double RecordingReader::duration() const {
+    return static_cast<double>(impl_->duration_us) / 1e6;
+}
+
+bool RecordingReader::seek(uint64_t frame, DebugVisualizer& tile) {
+    Impl& impl = *impl_;
+    if (frame >= impl.frame_count) {
+        return false;
+    }
+
+    auto it = std::upper_bound(impl.keyframes.begin(), impl.keyframes.end(), frame,
+                               [](uint64_t target, const IndexEntry& entry) {
+                                   return target < entry.frame;
+                               });
+    const IndexEntry* keyframe = it == impl.keyframes.begin() ? nullptr : &*(it - 1);
+    const bool step_forward = impl.positioned && impl.tile == &tile && impl.next_frame <= frame + 1 &&
+                              (!keyframe || keyframe->frame < impl.next_frame);
+    if (!step_forward) {
+        if (keyframe) {
+            if (!impl.LoadKeyframe(*keyframe, tile)) {
+                return false;
+            }
+        } else {
+            tile.clear();
+            impl.Rewind();
+        }
+    }
+
+    impl.tile = &tile;
+
+    ByteReader in(impl.data + impl.cursor, impl.data + impl.records_end);
+    const uint8_t* record = in.position();
+    while (!in.at_end()) {
+        record = in.position();
+        const Tag tag = static_cast<Tag>(in.u8());
+        if (tag == Tag::kFrame) {
+            if (impl.next_frame == frame + 1) {
+                break;
+            }
+            impl.time_us += in.varint();
+            ++impl.next_frame;
+        } else if (tag == Tag::kKeyframe) {
+            in.skip(in.varint());
+        } else if (!impl.decoder.apply(tag, in, &tile)) {
+            impl.positioned = false;
+            return false;
+        }
+        record = in.position();
+    }
+    if (!in.ok()) {
+        impl.positioned = false;
+        return false;
+    }
+    impl.cursor = static_cast<size_t>(record - impl.data);
+    return impl.next_frame == frame + 1;
+}
+
+uint64_t RecordingReader::frame() const {
+    return impl_->next_frame == 0 ? 0 : impl_->next_frame - 1;
+}
+
+double RecordingReader::time() const {
+    return static_cast<double>(impl_->time_us) / 1e6;
+}
+
+}  // namespace dbgvis
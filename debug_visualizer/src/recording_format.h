@@ -0,0 +1,394 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+namespace dbgvis {
+namespace recording {
+
+// File layout, all integers little-endian:
+//
+//   header   "DBGVREC1" u32:version string:tile_id
+//   records  u8:Tag followed by the tag's payload, see below
+//   footer   kIndex record, then a fixed 32-byte trailer:
+//            u64:frame_count u64:duration_us u64:index_offset "DBGVIDX1"
+//
+// Names (tabs and keys) are interned into file-local ids by kName records
+// that precede their first use. A kFrame record starts each flush that
+// recorded anything and carries the time since the previous frame. Every
+// keyframe_interval frames a kKeyframe record snapshots the whole tile,
+// including every name declared so far, so a reader can start decoding
+// there. A recording cut short by a crash has no footer; readers rebuild the
+// index by scanning.
+constexpr char kMagic[8] = {'D', 'B', 'G', 'V', 'R', 'E', 'C', '1'};
+constexpr char kIndexMagic[8] = {'D', 'B', 'G', 'V', 'I', 'D', 'X', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kTrailerSize = 32;
+
+enum class Tag : uint8_t {
+    kName = 1,         // varint:id string:name
+    kFrame = 2,        // varint:delta_us
+    kValue = 3,        // varint:tab varint:key scalar
+    kGraphConfig = 4,  // varint:tab varint:key varint:max_samples u8:flags f32:min f32:max
+    kGraphSample = 5,  // varint:tab varint:key f32:sample
+    kGraphSamples = 6, // varint:tab varint:key varint:count f32 * count
+    kStructure = 7,    // varint:tab varint:key varint:child_count node * child_count
+    kClearTab = 8,     // varint:tab
+    kKeyframe = 9,     // varint:body_size, body = varint:frame varint:time_us record *
+    kIndex = 10,       // varint:count (varint:frame varint:time_us varint:offset) * count
+    // varint:tab varint:key varint:max_samples u8:flags f32:min f32:max
+    // f64:time_window varint:count string:label * count
+    kSeriesConfig = 11,
+    // varint:tab varint:key varint:rows varint:columns f64:time * rows
+    // (f32 * rows) * columns
+    kSeriesSamples = 12,
+    // varint:tab varint:key f64:relative_accuracy f64:min_value f64:max_value
+    // varint:zero_count f64:sum f64:min f64:max zigzag:first_index
+    // varint:count varint * count; merged into the tab's sketch for key
+    kHistogram = 13,
+};
+
+// Scalar and structure node values: u8:kind then the payload.
+enum class ValueKind : uint8_t {
+    kNone = 0,
+    kInt = 1,     // zigzag varint
+    kDouble = 2,  // f64
+    kBool = 3,    // u8
+    kString = 4,  // string
+};
+
+enum GraphFlags : uint8_t {
+    kGraphAutoScale = 1 << 0,
+    kGraphLevelOfDetail = 1 << 1,
+};
+
+struct IndexEntry {
+    uint64_t frame = 0;
+    uint64_t time_us = 0;
+    uint64_t offset = 0;
+};
+
+class ByteWriter {
+public:
+    void u8(uint8_t value) {
+        bytes_.push_back(value);
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            bytes_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes_.push_back(static_cast<uint8_t>(value));
+    }
+
+    void zigzag(int64_t value) {
+        varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void fixed64(uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            bytes_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void f32(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 4; ++i) {
+            bytes_.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+        }
+    }
+
+    void f64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        fixed64(bits);
+    }
+
+    void string(std::string_view value) {
+        varint(value.size());
+        bytes_.insert(bytes_.end(), value.begin(), value.end());
+    }
+
+    void raw(const void* data, size_t size) {
+        const auto* begin = static_cast<const uint8_t*>(data);
+        bytes_.insert(bytes_.end(), begin, begin + size);
+    }
+
+    void scalar(const ScalarValue& value);
+    void node(const StructureNode& node);
+
+    size_t size() const {
+        return bytes_.size();
+    }
+    const uint8_t* data() const {
+        return bytes_.data();
+    }
+    void clear() {
+        bytes_.clear();
+    }
+    void truncate(size_t size) {
+        bytes_.resize(size);
+    }
+
+private:
+    std::vector<uint8_t> bytes_;
+};
+
+// Bounds-checked cursor over a mapped recording. Any overrun clears ok()
+// and makes every later read return zero.
+class ByteReader {
+public:
+    ByteReader(const uint8_t* begin, const uint8_t* end) : pos_(begin), end_(end) {}
+
+    bool ok() const {
+        return ok_;
+    }
+    bool at_end() const {
+        return pos_ >= end_;
+    }
+    const uint8_t* position() const {
+        return pos_;
+    }
+
+    uint8_t u8() {
+        if (!require(1)) {
+            return 0;
+        }
+        return *pos_++;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = u8();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        ok_ = false;
+        return 0;
+    }
+
+    int64_t zigzag() {
+        const uint64_t value = varint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    uint64_t fixed64() {
+        if (!require(8)) {
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(pos_[i]) << (8 * i);
+        }
+        pos_ += 8;
+        return value;
+    }
+
+    float f32() {
+        if (!require(4)) {
+            return 0.0f;
+        }
+        uint32_t bits = 0;
+        for (int i = 0; i < 4; ++i) {
+            bits |= static_cast<uint32_t>(pos_[i]) << (8 * i);
+        }
+        pos_ += 4;
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    double f64() {
+        const uint64_t bits = fixed64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string_view string() {
+        const uint64_t size = varint();
+        if (!require(size)) {
+            return {};
+        }
+        std::string_view value(reinterpret_cast<const char*>(pos_), static_cast<size_t>(size));
+        pos_ += size;
+        return value;
+    }
+
+    void skip(uint64_t size) {
+        if (require(size)) {
+            pos_ += size;
+        }
+    }
+
+    std::optional<ScalarValue> scalar();
+    StructureNode node(int depth = 0);
+
+private:
+    bool require(uint64_t size) {
+        if (!ok_ || static_cast<uint64_t>(end_ - pos_) < size) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t* pos_;
+    const uint8_t* end_;
+    bool ok_ = true;
+};
+
+// Encoding state shared by recordings and streams: the names and graph
+// configs declared so far and the bytes of the frame being built. Records are
+// appended to bytes(); the owner decides where they go.
+class Encoder {
+public:
+    // Forgets every declared name and starts the clock again.
+    void reset();
+
+    void value(const std::string& tab, const std::string& key, const ScalarValue& value);
+    void graph_sample(const std::string& tab, const std::string& key, const GraphConfig& config, float sample);
+    void graph_samples(const std::string& tab,
+                       const std::string& key,
+                       const GraphConfig& config,
+                       const std::vector<float>& samples);
+    void series_config(const std::string& tab, const std::string& key, const TimeSeriesConfig& config);
+    void series_sample(const std::string& tab, const std::string& key, double time, const std::vector<float>& values);
+    void histogram(const std::string& tab, const std::string& key, const QuantileSketch& sketch);
+    void structure(const std::string& tab, const std::string& key, const std::optional<StructureNode>& root);
+    void clear_tab(const std::string& tab);
+
+    bool frame_open() const {
+        return frame_open_;
+    }
+    void end_frame();
+    // Drops the records of the open frame, e.g. when a stream falls behind.
+    // Names it declared are declared again by the next keyframe.
+    void discard_frame();
+    // Appends a keyframe of `tile` and returns the offset of its kKeyframe
+    // record within bytes().
+    size_t keyframe(const DebugVisualizer& tile);
+
+    uint64_t frames() const {
+        return frames_;
+    }
+    uint64_t time_us() const {
+        return last_frame_us_;
+    }
+    const ByteWriter& bytes() const {
+        return out_;
+    }
+    void clear_bytes() {
+        out_.clear();
+    }
+
+private:
+    uint32_t name_id(const std::string& name);
+    void open_frame();
+    void graph_config(uint32_t tab, uint32_t key, const GraphConfig& config);
+
+    uint64_t start_us_ = 0;
+    uint64_t last_frame_us_ = 0;
+    uint64_t frames_ = 0;
+    bool frame_open_ = false;
+    size_t frame_begin_ = 0;
+    ByteWriter out_;
+    ByteWriter scratch_;
+    std::unordered_map<std::string, uint32_t> name_ids_;
+    std::vector<std::string> names_;
+    std::unordered_map<uint64_t, GraphConfig> graph_configs_;
+};
+
+// Read side: the names and graph configs of one decoding position.
+class Decoder {
+public:
+    void reset();
+    // Decodes one record whose tag has been read; applies it to `tile` when
+    // non-null. False on malformed input or an unexpected tag.
+    bool apply(Tag tag, ByteReader& in, DebugVisualizer* tile);
+    // Replaces `tile` with the records of a keyframe body; `in` is positioned
+    // after the body's frame and time.
+    bool keyframe(ByteReader& in, DebugVisualizer& tile);
+
+private:
+    const std::string& name(uint64_t id) const;
+
+    std::vector<std::string> names_;
+    std::unordered_map<uint64_t, GraphConfig> graph_configs_;
+    std::vector<float> samples_;
+    std::vector<double> times_;
+    std::vector<float> row_;
+};
+
+// Write side, owned by the background service thread. Records are buffered
+// per frame and written with one fwrite() in end_frame().
+class Recorder {
+public:
+    Recorder() = default;
+    ~Recorder();
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    bool open(const std::string& path, const std::string& tile_id, size_t keyframe_interval);
+    // Writes the index footer and closes the file.
+    void close();
+    bool is_open() const;
+
+    Encoder& encoder() {
+        return encoder_;
+    }
+    // Flushes this frame's records and, when one is due, a keyframe of `tile`.
+    void end_frame(const DebugVisualizer& tile);
+
+private:
+    void write(const ByteWriter& bytes);
+
+    std::FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    size_t keyframe_interval_ = 0;
+    size_t frames_since_keyframe_ = 0;
+    Encoder encoder_;
+    std::vector<IndexEntry> index_;
+};
+
+// Header shared by recordings and streams: magic, version, tile id.
+void WriteHeader(ByteWriter& out, const std::string& tile_id);
+// False when `in` does not start with a header of this version.
+bool ReadHeader(ByteReader& in, std::string& tile_id);
+
+}  // namespace recording
+}  // namespace dbgvis
@@ -0,0 +1,38 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#include "debug_visualizer/debug_visualizer.h"
+
+#include <cstdio>
+
+// Opens a recording written with DebugVisualizerAppOptions::record_path and
+// plays it back with seek/play controls.
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <recording>\n", argv[0]);
+        return 2;
+    }
+
+    dbgvis::DebugVisualizerAppOptions options;
+    options.window_title = "Debug Visualizer Replay";
+    options.replay_path = argv[1];
+    return dbgvis::RunVisualizerApp(options, {});
+}
@@ -0,0 +1,409 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#include "debug_visualizer/src/shm_transport.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "debug_visualizer/src/stream_transport.h"
+
+namespace dbgvis {
+namespace shm {
+namespace {
+constexpr const char* kShmDirectory = "/dev/shm";
+// Producers that keep a name busy get a numbered segment next to it.
+constexpr int kMaxSuffix = 16;
+constexpr size_t kMinCapacity = 64u << 10;
+// Bounds the time one poll() spends on a single producer.
+constexpr uint64_t kMaxReadPerPoll = 8u << 20;
+
+uint64_t NowMicros() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+// Heartbeats come from another process and may be a little ahead of `now`.
+bool Fresh(uint64_t heartbeat_us, uint64_t now_us) {
+    return heartbeat_us + static_cast<uint64_t>(Watcher::kStaleAfter.count()) * 1000 >= now_us;
+}
+
+uint64_t Align4(uint64_t value) {
+    return (value + 3) & ~uint64_t{3};
+}
+
+// Stream names may contain '/' and other characters shm_open() rejects.
+std::string SegmentName(const std::string& name) {
+    std::string result = kSegmentPrefix;
+    for (char c : name) {
+        const bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' ||
+                           c == '_' || c == '.';
+        result.push_back(plain ? c : '_');
+    }
+    return result;
+}
+
+bool ValidHeader(const SegmentHeader& header, size_t mapped_size) {
+    return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+           header.header_size >= sizeof(SegmentHeader) && header.capacity % 4 == 0 && header.capacity > 0 &&
+           header.header_size + header.capacity <= mapped_size;
+}
+
+// A segment another live producer still writes to.
+bool SegmentInUse(const std::string& segment) {
+    const int fd = shm_open(("/" + segment).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    bool in_use = false;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SegmentHeader)) {
+        void* mapped = mmap(nullptr, sizeof(SegmentHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            const auto* header = static_cast<const SegmentHeader*>(mapped);
+            in_use = header->closed.load(std::memory_order_acquire) == 0 &&
+                     Fresh(header->heartbeat_us.load(std::memory_order_relaxed), NowMicros());
+            munmap(mapped, sizeof(SegmentHeader));
+        }
+    }
+    ::close(fd);
+    return in_use;
+}
+}  // namespace
+
+Publisher::~Publisher() {
+    close();
+}
+
+bool Publisher::open(const std::string& name, size_t capacity) {
+    close();
+    const uint64_t ring_capacity = Align4(std::max<size_t>(capacity, kMinCapacity));
+    const uint64_t header_size = (sizeof(SegmentHeader) + 63) & ~uint64_t{63};
+    const std::string base = SegmentName(name);
+
+    int fd = -1;
+    std::string display = name;
+    for (int suffix = 1; suffix <= kMaxSuffix && fd < 0; ++suffix) {
+        const std::string segment = suffix == 1 ? base : base + "." + std::to_string(suffix);
+        if (SegmentInUse(segment)) {
+            continue;
+        }
+        // Left behind by a producer that is gone.
+        shm_unlink(("/" + segment).c_str());
+        fd = shm_open(("/" + segment).c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            segment_ = segment;
+            if (suffix > 1) {
+                display = name + " #" + std::to_string(suffix);
+            }
+        }
+    }
+    if (fd < 0) {
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(header_size + ring_capacity);
+    void* mapped = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(("/" + segment_).c_str());
+        segment_.clear();
+        return false;
+    }
+
+    // ftruncate() zero-fills, which is the initial state of every field; the
+    // magic goes in last so a viewer never attaches to a half-built header.
+    mapped_size_ = size;
+    header_ = static_cast<SegmentHeader*>(mapped);
+    ring_ = static_cast<uint8_t*>(mapped) + header_size;
+    header_->version = kVersion;
+    header_->header_size = static_cast<uint32_t>(header_size);
+    header_->capacity = ring_capacity;
+    std::strncpy(header_->name, display.c_str(), kMaxNameSize - 1);
+    header_->heartbeat_us.store(NowMicros(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+
+    seen_attach_ = 0;
+    in_sync_ = false;
+    blocked_ = false;
+    encoder_.reset();
+    return true;
+}
+
+void Publisher::close() {
+    if (!header_) {
+        return;
+    }
+    header_->closed.store(1, std::memory_order_release);
+    munmap(header_, mapped_size_);
+    shm_unlink(("/" + segment_).c_str());
+    header_ = nullptr;
+    ring_ = nullptr;
+    mapped_size_ = 0;
+    segment_.clear();
+    in_sync_ = false;
+}
+
+bool Publisher::TryWrite(const recording::ByteWriter& bytes) {
+    const uint64_t capacity = header_->capacity;
+    const uint64_t need = Align4(4 + bytes.size());
+    uint64_t write = header_->write_pos.load(std::memory_order_relaxed);
+    const uint64_t read = header_->read_pos.load(std::memory_order_acquire);
+    uint64_t offset = write % capacity;
+    const uint64_t tail = capacity - offset;
+    const uint64_t total = need + (tail < need ? tail : 0);
+    if (need > capacity || write + total - read > capacity) {
+        return false;
+    }
+    if (tail < need) {
+        std::memcpy(ring_ + offset, &kPadding, sizeof(kPadding));
+        write += tail;
+        offset = 0;
+    }
+    const uint32_t size = static_cast<uint32_t>(bytes.size());
+    std::memcpy(ring_ + offset, &size, sizeof(size));
+    std::memcpy(ring_ + offset + 4, bytes.data(), bytes.size());
+    header_->write_pos.store(write + need, std::memory_order_release);
+    return true;
+}
+
+void Publisher::end_frame(const DebugVisualizer& tile) {
+    if (!header_) {
+        return;
+    }
+    header_->heartbeat_us.store(NowMicros(), std::memory_order_relaxed);
+    const uint64_t attach = header_->attach_count.load(std::memory_order_acquire);
+    if (attach != seen_attach_) {
+        seen_attach_ = attach;
+        in_sync_ = false;
+        blocked_ = false;
+    }
+    if (attach == 0) {
+        return;
+    }
+
+    if (encoder_.frame_open()) {
+        encoder_.end_frame();
+        if (!TryWrite(encoder_.bytes())) {
+            in_sync_ = false;
+        }
+        encoder_.clear_bytes();
+    }
+    if (!in_sync_) {
+        const uint64_t read = header_->read_pos.load(std::memory_order_acquire);
+        if (blocked_ && read == blocked_at_) {
+            return;
+        }
+        encoder_.keyframe(tile);
+        in_sync_ = TryWrite(encoder_.bytes());
+        encoder_.clear_bytes();
+        blocked_ = !in_sync_;
+        blocked_at_ = read;
+    }
+}
+
+Watcher::~Watcher() {
+    close();
+}
+
+bool Watcher::listen(const std::string& prefix) {
+    close();
+    DIR* directory = opendir(kShmDirectory);
+    if (!directory) {
+        return false;
+    }
+    closedir(directory);
+    prefix_ = SegmentName(prefix);
+    listening_ = true;
+    next_scan_ = {};
+    return true;
+}
+
+void Watcher::close() {
+    for (auto& segment : segments_) {
+        Unmap(segment);
+    }
+    segments_.clear();
+    listening_ = false;
+}
+
+void Watcher::Unmap(Segment& segment) {
+    if (segment.header) {
+        munmap(segment.header, segment.mapped_size);
+        segment.header = nullptr;
+        segment.ring = nullptr;
+    }
+}
+
+void Watcher::Scan(DebugVisualizer& visualizer) {
+    DIR* directory = opendir(kShmDirectory);
+    if (!directory) {
+        return;
+    }
+    while (dirent* entry = readdir(directory)) {
+        const std::string file = entry->d_name;
+        if (file.compare(0, prefix_.size(), prefix_) != 0) {
+            continue;
+        }
+        const uint64_t inode = static_cast<uint64_t>(entry->d_ino);
+        const bool attached = std::any_of(segments_.begin(), segments_.end(), [&](const Segment& segment) {
+            return segment.file == file && segment.inode == inode;
+        });
+        if (!attached) {
+            Attach(file, inode, visualizer);
+        }
+    }
+    closedir(directory);
+}
+
+bool Watcher::Attach(const std::string& file, uint64_t inode, DebugVisualizer& visualizer) {
+    const int fd = shm_open(("/" + file).c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    size_t size = 0;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SegmentHeader)) {
+        size = static_cast<size_t>(info.st_size);
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    auto* header = static_cast<SegmentHeader*>(mapped);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!ValidHeader(*header, size)) {
+        // Possibly still being created; the next scan looks again.
+        munmap(mapped, size);
+        return false;
+    }
+
+    // Replaces the mapping of a producer that restarted under this name.
+    auto previous = std::find_if(segments_.begin(), segments_.end(), [&](const Segment& segment) {
+        return segment.file == file;
+    });
+    if (previous != segments_.end()) {
+        Unmap(*previous);
+        segments_.erase(previous);
+    }
+
+    Segment segment;
+    segment.file = file;
+    segment.header = header;
+    segment.ring = static_cast<uint8_t*>(mapped) + header->header_size;
+    segment.mapped_size = size;
+    segment.inode = inode;
+    segment.tile_id = std::string(header->name, strnlen(header->name, kMaxNameSize));
+    if (segment.tile_id.empty()) {
+        segment.tile_id = file;
+    }
+    // Skip whatever the producer wrote for an earlier viewer; the attach
+    // bump makes it send a keyframe.
+    segment.read = header->write_pos.load(std::memory_order_acquire);
+    header->read_pos.store(segment.read, std::memory_order_release);
+    header->attach_count.fetch_add(1, std::memory_order_acq_rel);
+    visualizer.window_tile(segment.tile_id).set_window_title(segment.tile_id + "###" + segment.tile_id);
+    segments_.push_back(std::move(segment));
+    return true;
+}
+
+bool Watcher::Drain(Segment& segment, DebugVisualizer& visualizer, bool& changed) {
+    SegmentHeader& header = *segment.header;
+    const uint64_t capacity = header.capacity;
+    const uint64_t write = header.write_pos.load(std::memory_order_acquire);
+    if (write - segment.read > capacity) {
+        return false;
+    }
+
+    DebugVisualizer& tile = visualizer.window_tile(segment.tile_id);
+    const uint64_t budget_end = segment.read + kMaxReadPerPoll;
+    bool ok = true;
+    while (ok && segment.read < write && segment.read < budget_end) {
+        const uint64_t offset = segment.read % capacity;
+        uint32_t size = 0;
+        std::memcpy(&size, segment.ring + offset, sizeof(size));
+        if (size == kPadding) {
+            segment.read += capacity - offset;
+            continue;
+        }
+        const uint64_t need = Align4(4 + static_cast<uint64_t>(size));
+        if (need > capacity - offset || segment.read + need > write) {
+            ok = false;
+            break;
+        }
+        ok = stream::ApplyMessage(segment.ring + offset + 4, size, segment.decoder, tile, segment.synced);
+        segment.read += need;
+        changed = true;
+    }
+    header.read_pos.store(segment.read, std::memory_order_release);
+    return ok;
+}
+
+bool Watcher::poll(DebugVisualizer& visualizer) {
+    if (!listening_) {
+        return false;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= next_scan_) {
+        Scan(visualizer);
+        next_scan_ = now + kScanInterval;
+    }
+
+    bool changed = false;
+    const uint64_t now_us = NowMicros();
+    for (auto it = segments_.begin(); it != segments_.end();) {
+        Segment& segment = *it;
+        const bool ok = Drain(segment, visualizer, changed);
+        const bool closed = segment.header->closed.load(std::memory_order_acquire) != 0;
+        const uint64_t heartbeat = segment.header->heartbeat_us.load(std::memory_order_relaxed);
+        const bool stale = closed || !ok || !Fresh(heartbeat, now_us);
+        if (stale != segment.stale) {
+            segment.stale = stale;
+            const std::string suffix = stale ? " (disconnected)###" : "###";
+            visualizer.window_tile(segment.tile_id).set_window_title(segment.tile_id + suffix + segment.tile_id);
+            changed = true;
+        }
+        if (closed || !ok) {
+            Unmap(segment);
+            it = segments_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return changed;
+}
+
+}  // namespace shm
+}  // namespace dbgvis
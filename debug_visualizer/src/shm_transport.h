@@ -0,0 +1,157 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "debug_visualizer/debug_visualizer.h"
+#include "debug_visualizer/src/recording_format.h"
+
+namespace dbgvis {
+namespace shm {
+
+// One POSIX shared-memory segment per producer, /dev/shm/dbgvis.<name>,
+// holding a single-producer/single-consumer byte ring of stream messages
+// (see stream_transport.h): a native u32 size, then the records. A message
+// never wraps; kPadding fills the tail of the ring instead. The viewer
+// decodes messages in place and only then releases them through read_pos.
+constexpr char kMagic[8] = {'D', 'B', 'G', 'V', 'S', 'H', 'M', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kPadding = 0xffffffffu;
+constexpr size_t kMaxNameSize = 128;
+constexpr const char* kSegmentPrefix = "dbgvis.";
+// stream_address / listen_address scheme. A viewer may add a prefix,
+// "shm:ingest", to only watch producers whose stream name starts with it.
+constexpr char kScheme[] = "shm:";
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity;
+    char name[kMaxNameSize];
+
+    alignas(64) std::atomic<uint64_t> write_pos;
+    std::atomic<uint64_t> heartbeat_us;
+    std::atomic<uint32_t> closed;
+
+    alignas(64) std::atomic<uint64_t> read_pos;
+    // Bumped by each viewer that attaches; the producer answers with a
+    // keyframe.
+    std::atomic<uint64_t> attach_count;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "segment atomics must be address-free");
+
+// Producer side, owned by the background service thread. Writing a frame is
+// a memcpy into the mapping plus one release store: no syscalls, no waiting.
+// Nothing is encoded until a viewer attaches. A frame that does not fit is
+// dropped and a keyframe follows once the viewer has made room.
+class Publisher {
+public:
+    Publisher() = default;
+    ~Publisher();
+    Publisher(const Publisher&) = delete;
+    Publisher& operator=(const Publisher&) = delete;
+
+    bool open(const std::string& name, size_t capacity);
+    // Marks the segment closed and removes its name.
+    void close();
+    bool streaming() const {
+        return header_ != nullptr && in_sync_;
+    }
+
+    recording::Encoder& encoder() {
+        return encoder_;
+    }
+    void end_frame(const DebugVisualizer& tile);
+
+private:
+    bool TryWrite(const recording::ByteWriter& bytes);
+
+    SegmentHeader* header_ = nullptr;
+    uint8_t* ring_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::string segment_;
+    uint64_t seen_attach_ = 0;
+    bool in_sync_ = false;
+    // read_pos when a keyframe last failed to fit; retried once it moves.
+    uint64_t blocked_at_ = 0;
+    bool blocked_ = false;
+    recording::Encoder encoder_;
+};
+
+// Viewer side: attaches to every producer segment and drains them into one
+// window tile each, named after the producer.
+class Watcher {
+public:
+    static constexpr std::chrono::milliseconds kScanInterval{500};
+    // A producer whose heartbeat is older than this is shown disconnected.
+    static constexpr std::chrono::milliseconds kStaleAfter{3000};
+
+    Watcher() = default;
+    ~Watcher();
+    Watcher(const Watcher&) = delete;
+    Watcher& operator=(const Watcher&) = delete;
+
+    // Watches segments whose name starts with `prefix` (empty: all).
+    bool listen(const std::string& prefix);
+    void close();
+    bool poll(DebugVisualizer& visualizer);
+    size_t segment_count() const {
+        return segments_.size();
+    }
+
+private:
+    struct Segment {
+        std::string file;
+        SegmentHeader* header = nullptr;
+        uint8_t* ring = nullptr;
+        size_t mapped_size = 0;
+        // A producer restarting under the same name creates a new file.
+        uint64_t inode = 0;
+        uint64_t read = 0;
+        std::string tile_id;
+        bool synced = false;
+        bool stale = false;
+        recording::Decoder decoder;
+    };
+
+    void Scan(DebugVisualizer& visualizer);
+    bool Attach(const std::string& file, uint64_t inode, DebugVisualizer& visualizer);
+    // False when the segment is gone or corrupt.
+    bool Drain(Segment& segment, DebugVisualizer& visualizer, bool& changed);
+    static void Unmap(Segment& segment);
+
+    bool listening_ = false;
+    std::string prefix_;
+    std::chrono::steady_clock::time_point next_scan_{};
+    std::vector<Segment> segments_;
+};
+
+}  // namespace shm
+}  // namespace dbgvis
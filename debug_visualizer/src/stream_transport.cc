@@ -0,0 +1,484 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#include "debug_visualizer/src/stream_transport.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace dbgvis {
+namespace stream {
+namespace {
+using recording::ByteReader;
+using recording::ByteWriter;
+using recording::Tag;
+
+// Bounds the time one poll() spends on a single producer.
+constexpr size_t kMaxReadPerPoll = 8u << 20;
+constexpr size_t kReadChunk = 64u << 10;
+// Header: magic, version and a name; anything longer is not a producer.
+constexpr size_t kMaxHeaderSize = 4096;
+
+bool FillUnixAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    return true;
+}
+
+addrinfo* Resolve(const Address& address, bool passive) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    const char* host = address.host.empty() ? (passive ? nullptr : "localhost") : address.host.c_str();
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host, address.port.c_str(), &hints, &result) != 0) {
+        return nullptr;
+    }
+    return result;
+}
+
+uint32_t ReadU32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+}  // namespace
+
+bool ParseAddress(const std::string& text, Address& address) {
+    address = Address{};
+    if (text.rfind("unix:", 0) == 0) {
+        address.is_unix = true;
+        address.path = text.substr(5);
+        return !address.path.empty();
+    }
+    std::string rest = text.rfind("tcp:", 0) == 0 ? text.substr(4) : text;
+    const size_t colon = rest.rfind(':');
+    if (colon == std::string::npos || colon + 1 == rest.size()) {
+        return false;
+    }
+    address.host = rest.substr(0, colon);
+    address.port = rest.substr(colon + 1);
+    if (address.host.size() >= 2 && address.host.front() == '[' && address.host.back() == ']') {
+        address.host = address.host.substr(1, address.host.size() - 2);
+    }
+    return std::all_of(address.port.begin(), address.port.end(), [](char c) {
+        return c >= '0' && c <= '9';
+    });
+}
+
+bool ApplyMessage(const uint8_t* data, size_t size, recording::Decoder& decoder, DebugVisualizer& tile, bool& synced) {
+    ByteReader in(data, data + size);
+    while (!in.at_end()) {
+        const Tag tag = static_cast<Tag>(in.u8());
+        bool ok = true;
+        if (tag == Tag::kFrame) {
+            in.varint();
+        } else if (tag == Tag::kKeyframe) {
+            const uint64_t body_size = in.varint();
+            if (!in.ok() || body_size > static_cast<uint64_t>(data + size - in.position())) {
+                return false;
+            }
+            ByteReader body(in.position(), in.position() + body_size);
+            body.varint();
+            body.varint();
+            ok = decoder.keyframe(body, tile);
+            synced = synced || ok;
+            in.skip(body_size);
+        } else {
+            ok = decoder.apply(tag, in, synced ? &tile : nullptr);
+        }
+        if (!ok || !in.ok()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Sender::~Sender() {
+    close();
+}
+
+bool Sender::open(const std::string& address, const std::string& name) {
+    close();
+    if (!ParseAddress(address, address_)) {
+        return false;
+    }
+    name_ = name;
+    configured_ = true;
+    next_attempt_ = {};
+    Connect();
+    return true;
+}
+
+void Sender::close() {
+    Disconnect();
+    configured_ = false;
+}
+
+void Sender::Connect() {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_attempt_) {
+        return;
+    }
+    next_attempt_ = now + kReconnectInterval;
+
+    int fd = -1;
+    bool pending = false;
+    if (address_.is_unix) {
+        sockaddr_un addr;
+        if (!FillUnixAddress(address_.path, addr)) {
+            return;
+        }
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    } else {
+        addrinfo* results = Resolve(address_, false);
+        for (addrinfo* it = results; it && fd < 0; it = it->ai_next) {
+            fd = ::socket(it->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                continue;
+            }
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (::connect(fd, it->ai_addr, it->ai_addrlen) == 0) {
+                break;
+            }
+            if (errno == EINPROGRESS) {
+                pending = true;
+                break;
+            }
+            ::close(fd);
+            fd = -1;
+        }
+        if (results) {
+            freeaddrinfo(results);
+        }
+    }
+    if (fd < 0) {
+        return;
+    }
+
+    fd_ = fd;
+    connecting_ = pending;
+    in_sync_ = false;
+    encoder_.reset();
+    backlog_.clear();
+    backlog_sent_ = 0;
+    ByteWriter header;
+    recording::WriteHeader(header, name_);
+    backlog_.insert(backlog_.end(), header.data(), header.data() + header.size());
+}
+
+void Sender::Disconnect() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    connecting_ = false;
+    in_sync_ = false;
+    backlog_.clear();
+    backlog_sent_ = 0;
+    encoder_.clear_bytes();
+}
+
+void Sender::Queue(const ByteWriter& bytes) {
+    const uint32_t size = static_cast<uint32_t>(bytes.size());
+    for (int i = 0; i < 4; ++i) {
+        backlog_.push_back(static_cast<uint8_t>(size >> (8 * i)));
+    }
+    backlog_.insert(backlog_.end(), bytes.data(), bytes.data() + bytes.size());
+}
+
+bool Sender::Send() {
+    while (backlog_sent_ < backlog_.size()) {
+        const ssize_t sent =
+            ::send(fd_, backlog_.data() + backlog_sent_, backlog_.size() - backlog_sent_, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent > 0) {
+            backlog_sent_ += static_cast<size_t>(sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (backlog_sent_ == backlog_.size()) {
+        backlog_.clear();
+        backlog_sent_ = 0;
+    } else if (backlog_sent_ * 2 >= backlog_.size()) {
+        using difference_type = std::vector<uint8_t>::difference_type;
+        backlog_.erase(backlog_.begin(), backlog_.begin() + static_cast<difference_type>(backlog_sent_));
+        backlog_sent_ = 0;
+    }
+    return true;
+}
+
+void Sender::end_frame(const DebugVisualizer& tile) {
+    if (!configured_) {
+        return;
+    }
+    if (fd_ < 0) {
+        Connect();
+        if (fd_ < 0) {
+            return;
+        }
+    }
+    if (connecting_) {
+        pollfd ready{fd_, POLLOUT, 0};
+        if (::poll(&ready, 1, 0) <= 0) {
+            return;
+        }
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            Disconnect();
+            return;
+        }
+        connecting_ = false;
+    }
+
+    if (encoder_.frame_open()) {
+        encoder_.end_frame();
+        const size_t backlog = backlog_.size() - backlog_sent_;
+        if (backlog + 4 + encoder_.bytes().size() > kMaxBacklogBytes) {
+            in_sync_ = false;
+        } else {
+            Queue(encoder_.bytes());
+        }
+        encoder_.clear_bytes();
+    }
+    if (!Send()) {
+        Disconnect();
+        return;
+    }
+    if (!in_sync_ && backlog_.empty()) {
+        encoder_.keyframe(tile);
+        Queue(encoder_.bytes());
+        encoder_.clear_bytes();
+        in_sync_ = true;
+        if (!Send()) {
+            Disconnect();
+        }
+    }
+}
+
+Server::~Server() {
+    close();
+}
+
+bool Server::listen(const std::string& text) {
+    close();
+    Address address;
+    if (!ParseAddress(text, address)) {
+        return false;
+    }
+
+    int fd = -1;
+    if (address.is_unix) {
+        sockaddr_un addr;
+        if (!FillUnixAddress(address.path, addr)) {
+            return false;
+        }
+        // A socket file left behind by a viewer that did not shut down.
+        struct stat info;
+        if (::stat(address.path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+            ::unlink(address.path.c_str());
+        }
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        if (fd >= 0) {
+            unix_path_ = address.path;
+        }
+    } else {
+        addrinfo* results = Resolve(address, true);
+        for (addrinfo* it = results; it && fd < 0; it = it->ai_next) {
+            fd = ::socket(it->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                continue;
+            }
+            const int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (::bind(fd, it->ai_addr, it->ai_addrlen) != 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        if (results) {
+            freeaddrinfo(results);
+        }
+    }
+    if (fd < 0) {
+        return false;
+    }
+    if (::listen(fd, 16) != 0) {
+        ::close(fd);
+        close();
+        return false;
+    }
+    listen_fd_ = fd;
+    return true;
+}
+
+void Server::close() {
+    for (auto& connection : connections_) {
+        ::close(connection.fd);
+    }
+    connections_.clear();
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    if (!unix_path_.empty()) {
+        ::unlink(unix_path_.c_str());
+        unix_path_.clear();
+    }
+}
+
+std::string Server::UniqueTileId(const std::string& name) const {
+    const std::string base = name.empty() ? std::string("stream") : name;
+    std::string candidate = base;
+    for (int suffix = 2;; ++suffix) {
+        const bool taken = std::any_of(connections_.begin(), connections_.end(), [&](const Connection& connection) {
+            return connection.greeted && connection.tile_id == candidate;
+        });
+        if (!taken) {
+            return candidate;
+        }
+        candidate = base + " #" + std::to_string(suffix);
+    }
+}
+
+bool Server::poll(DebugVisualizer& visualizer) {
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    for (;;) {
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            break;
+        }
+        Connection connection;
+        connection.fd = fd;
+        connections_.push_back(std::move(connection));
+    }
+
+    bool changed = false;
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if (Receive(*it, visualizer, changed)) {
+            ++it;
+            continue;
+        }
+        if (it->greeted) {
+            visualizer.window_tile(it->tile_id).set_window_title(it->tile_id + " (disconnected)###" + it->tile_id);
+            changed = true;
+        }
+        ::close(it->fd);
+        it = connections_.erase(it);
+    }
+    return changed;
+}
+
+bool Server::Receive(Connection& connection, DebugVisualizer& visualizer, bool& changed) {
+    bool open = true;
+    size_t received = 0;
+    while (received < kMaxReadPerPoll) {
+        const size_t used = connection.buffer.size();
+        connection.buffer.resize(used + kReadChunk);
+        const ssize_t count = ::recv(connection.fd, connection.buffer.data() + used, kReadChunk, MSG_DONTWAIT);
+        connection.buffer.resize(used + static_cast<size_t>(std::max<ssize_t>(count, 0)));
+        if (count > 0) {
+            received += static_cast<size_t>(count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        open = count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        break;
+    }
+    return Decode(connection, visualizer, changed) && open;
+}
+
+bool Server::Decode(Connection& connection, DebugVisualizer& visualizer, bool& changed) {
+    std::vector<uint8_t>& buffer = connection.buffer;
+    size_t position = 0;
+    if (!connection.greeted) {
+        if (buffer.size() >= sizeof(recording::kMagic) &&
+            std::memcmp(buffer.data(), recording::kMagic, sizeof(recording::kMagic)) != 0) {
+            return false;
+        }
+        ByteReader header(buffer.data(), buffer.data() + buffer.size());
+        std::string name;
+        if (!recording::ReadHeader(header, name)) {
+            return header.ok() ? false : buffer.size() < kMaxHeaderSize;
+        }
+        connection.tile_id = UniqueTileId(name);
+        connection.greeted = true;
+        visualizer.window_tile(connection.tile_id).set_window_title(connection.tile_id + "###" + connection.tile_id);
+        position = static_cast<size_t>(header.position() - buffer.data());
+    }
+
+    bool ok = true;
+    DebugVisualizer& tile = visualizer.window_tile(connection.tile_id);
+    while (ok && buffer.size() - position >= 4) {
+        const uint32_t size = ReadU32(buffer.data() + position);
+        if (size > kMaxMessageSize) {
+            ok = false;
+            break;
+        }
+        if (buffer.size() - position - 4 < size) {
+            break;
+        }
+        ok = ApplyMessage(buffer.data() + position + 4, size, connection.decoder, tile, connection.synced);
+        position += 4 + size;
+        changed = true;
+    }
+
+    using difference_type = std::vector<uint8_t>::difference_type;
+    buffer.erase(buffer.begin(), buffer.begin() + static_cast<difference_type>(position));
+    return ok;
+}
+
+}  // namespace stream
+}  // namespace dbgvis
@@ -0,0 +1,146 @@
+/*
+ *  This file is part of ImGui Debug Visualizer project.
+ *  Copyright (C) 2025 buzzcola3 (Samuel Betak)
+ *
+ *  ImGui Debug Visualizer is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ImGui Debug Visualizer is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ImGui Debug Visualizer. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Author: buzzcola3 (Samuel Betak)
+ *  Email: buzzcola3@gmail.com
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "debug_visualizer/debug_visualizer.h"
+#include "debug_visualizer/src/recording_format.h"
+
+namespace dbgvis {
+namespace stream {
+
+// A stream is the recording header followed by messages, each a u32 byte
+// count and then whole records in the recording format. The first message
+// after (re)connecting, and after frames were dropped, is a keyframe.
+constexpr size_t kMaxMessageSize = 64u << 20;
+
+// "unix:/path/to/socket" or "tcp:host:port" ("host:port" is TCP too).
+struct Address {
+    bool is_unix = false;
+    std::string path;
+    std::string host;
+    std::string port;
+};
+
+bool ParseAddress(const std::string& text, Address& address);
+
+// Applies the records of one message to `tile`. Until the first keyframe
+// sets `synced`, records only update the decoder's names: they are deltas
+// against a state the reader never saw.
+bool ApplyMessage(const uint8_t* data, size_t size, recording::Decoder& decoder, DebugVisualizer& tile, bool& synced);
+
+// Producer side, owned by the background service thread. Connects lazily,
+// never blocks: each frame is queued as one message and written with
+// non-blocking send(). When the unsent backlog would pass
+// kMaxBacklogBytes the frame is dropped and, once the backlog drains, a
+// keyframe brings the viewer back in sync. A missing viewer is retried
+// every kReconnectInterval.
+class Sender {
+public:
+    static constexpr size_t kMaxBacklogBytes = 4u << 20;
+    static constexpr std::chrono::milliseconds kReconnectInterval{1000};
+
+    Sender() = default;
+    ~Sender();
+    Sender(const Sender&) = delete;
+    Sender& operator=(const Sender&) = delete;
+
+    bool open(const std::string& address, const std::string& name);
+    void close();
+    // Whether updates of the current frame should be encoded.
+    bool streaming() const {
+        return fd_ >= 0 && !connecting_ && in_sync_;
+    }
+
+    recording::Encoder& encoder() {
+        return encoder_;
+    }
+    // Queues this frame's records, or a keyframe of `tile` when the viewer
+    // has to resynchronise, and writes as much as the socket takes.
+    void end_frame(const DebugVisualizer& tile);
+
+private:
+    void Connect();
+    void Disconnect();
+    void Queue(const recording::ByteWriter& bytes);
+    // False when the connection failed.
+    bool Send();
+
+    Address address_;
+    std::string name_;
+    bool configured_ = false;
+    int fd_ = -1;
+    bool connecting_ = false;
+    bool in_sync_ = false;
+    std::chrono::steady_clock::time_point next_attempt_{};
+    recording::Encoder encoder_;
+    std::vector<uint8_t> backlog_;
+    size_t backlog_sent_ = 0;
+};
+
+// Viewer side. Each accepted producer gets its own window tile, named after
+// the stream; a second producer with a name already connected gets a
+// numbered suffix. Tiles stay after their producer disconnects, and a
+// producer reconnecting under the same name takes its tile back.
+class Server {
+public:
+    Server() = default;
+    ~Server();
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    bool listen(const std::string& address);
+    void close();
+    // Accepts new producers and applies what they sent since the last call.
+    // True when any tile changed.
+    bool poll(DebugVisualizer& visualizer);
+    size_t connection_count() const {
+        return connections_.size();
+    }
+
+private:
+    struct Connection {
+        int fd = -1;
+        bool greeted = false;
+        bool synced = false;
+        std::string tile_id;
+        std::vector<uint8_t> buffer;
+        recording::Decoder decoder;
+    };
+
+    // False when the connection must be dropped.
+    bool Receive(Connection& connection, DebugVisualizer& visualizer, bool& changed);
+    bool Decode(Connection& connection, DebugVisualizer& visualizer, bool& changed);
+    std::string UniqueTileId(const std::string& name) const;
+
+    int listen_fd_ = -1;
+    std::string unix_path_;
+    std::vector<Connection> connections_;
+};
+
+}  // namespace stream
+}  // namespace dbgvis
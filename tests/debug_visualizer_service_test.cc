@@ -0,0 +1,507 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+namespace {
+bool WaitUntilRunning() {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!dbgvis::IsBackgroundVisualizerRunning()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Holds the service thread inside a flush, so everything published until
+// release() is drained by one later flush.
+class Gate {
+public:
+    Gate() {
+        dbgvis::structure("Gate", "gate", [this](dbgvis::StructureBuilder&) {
+            stalled_.store(true);
+            while (!released_.load()) {
+                std::this_thread::yield();
+            }
+        });
+        while (!stalled_.load()) {
+            std::this_thread::yield();
+        }
+    }
+
+    void release() {
+        released_.store(true);
+    }
+
+private:
+    std::atomic<bool> stalled_{false};
+    std::atomic<bool> released_{false};
+};
+
+template <typename Done>
+bool WaitFor(Done done) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+}  // namespace
+
+int main() {
+    dbgvis::DebugVisualizerAppOptions options;
+    options.headless = true;
+    options.headless_update_hz = 200.0f;
+    // Headless keeps its fixed tick, but producers still go through the wake-up path.
+    options.render_on_change = true;
+    dbgvis::StartBackgroundVisualizer(options);
+    if (!WaitUntilRunning()) {
+        return 1;
+    }
+
+    const dbgvis::Key rx_bytes = dbgvis::register_value("Net", "rx_bytes");
+    for (int i = 0; i < 1000; ++i) {
+        dbgvis::value("Telemetry", "Counter/Current value", i);
+        dbgvis::value(rx_bytes, static_cast<int64_t>(i));
+        dbgvis::graph_sample("Telemetry", "Counter Value", static_cast<float>(i));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    if (!dbgvis::IsBackgroundVisualizerRunning() || dbgvis::DroppedUpdateCount() != 0) {
+        return 2;
+    }
+
+    // Tab statistics refresh twice a second.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    dbgvis::VisualizerStats stats = dbgvis::GetVisualizerStats();
+    const auto telemetry = [&stats]() -> const dbgvis::TabStats* {
+        for (const auto& tab : stats.tabs) {
+            if (tab.id == "Telemetry") {
+                return &tab;
+            }
+        }
+        return nullptr;
+    };
+    while ((stats.updates_applied < 3000 || !telemetry()) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = dbgvis::GetVisualizerStats();
+    }
+    const dbgvis::TabStats* tab = telemetry();
+    if (!stats.running || stats.updates_applied < 3000 || stats.frames == 0 || stats.peak_queue_depth == 0 || !tab ||
+        tab->scalars != 1 || tab->graphs != 1 || tab->graph_bytes.empty() || tab->graph_bytes[0].second == 0) {
+        return 4;
+    }
+
+    // Counters and gauges reach the tab without going through the queue.
+    dbgvis::Counter packets("Net", "packets");
+    dbgvis::Gauge load("Net", "load");
+    std::vector<std::thread> senders;
+    for (int t = 0; t < 4; ++t) {
+        senders.emplace_back([packets]() mutable {
+            for (int i = 0; i < 1000; ++i) {
+                packets.add();
+            }
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    load.set(0.5);
+    const auto net_scalars = [&stats] {
+        for (const auto& tab : stats.tabs) {
+            if (tab.id == "Net") {
+                return tab.scalars;
+            }
+        }
+        return size_t{0};
+    };
+    const auto net_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (net_scalars() != 3 && std::chrono::steady_clock::now() < net_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = dbgvis::GetVisualizerStats();
+    }
+    if (packets.value() != 4000 || load.value() != 0.5 || net_scalars() != 3) {
+        return 6;
+    }
+
+    // Nested zones are posted by flush_zones(); the worker's only zone is
+    // posted as its thread exits, and the idle thread's is taken by the
+    // service.
+    for (int i = 0; i < 10; ++i) {
+        DBGVIS_SCOPE("Outer");
+        DBGVIS_SCOPE("Inner");
+    }
+    {
+        // Two scopes on one line must not collide.
+        DBGVIS_SCOPE("Same line outer"); DBGVIS_SCOPE("Same line inner");
+    }
+    dbgvis::flush_zones();
+    std::thread([] {
+        DBGVIS_SCOPE("Worker");
+    }).join();
+    std::atomic<bool> idle_done{false};
+    std::thread idle([&idle_done] {
+        {
+            DBGVIS_SCOPE("Idle");
+        }
+        while (!idle_done.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    const auto zone_graphs = [&stats] {
+        for (const auto& tab : stats.tabs) {
+            if (tab.id != "Profiler") {
+                continue;
+            }
+            size_t found = 0;
+            for (const auto& [key, bytes] : tab.graph_bytes) {
+                found += key == "Outer mean (ms)" || key == "Inner p99 (ms)" || key == "Worker mean (ms)" ||
+                         key == "Idle mean (ms)";
+            }
+            return found;
+        }
+        return size_t{0};
+    };
+    const auto zone_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (zone_graphs() != 4 && std::chrono::steady_clock::now() < zone_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = dbgvis::GetVisualizerStats();
+    }
+    idle_done.store(true);
+    idle.join();
+    if (zone_graphs() != 4) {
+        return 5;
+    }
+
+    dbgvis::ShutdownBackgroundVisualizer();
+    if (dbgvis::IsBackgroundVisualizerRunning()) {
+        return 3;
+    }
+
+    // With flush workers, one large flush spread over several tabs keeps
+    // each tab's order, including a clear_tab() in the middle of it.
+    options.flush_threads = 3;
+    dbgvis::StartBackgroundVisualizer(options);
+    if (!WaitUntilRunning()) {
+        return 7;
+    }
+    std::atomic<bool> stalled{false};
+    std::atomic<bool> release{false};
+    dbgvis::structure("Gate", "gate", [&](dbgvis::StructureBuilder&) {
+        stalled.store(true);
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!stalled.load()) {
+        std::this_thread::yield();
+    }
+    for (int i = 0; i < 4000; ++i) {
+        if (i > 2000 && i % 8 == 3) {
+            continue;
+        }
+        const std::string tab = "Shard " + std::to_string(i % 8);
+        dbgvis::value(tab, "key " + std::to_string(i % 64), i);
+        dbgvis::graph_sample(tab, "samples", static_cast<float>(i));
+        if (i == 2000) {
+            dbgvis::clear_tab("Shard 3");
+            dbgvis::value("Shard 3", "after clear", i);
+        }
+    }
+    release.store(true);
+    const auto shard = [&stats](const std::string& id) -> const dbgvis::TabStats* {
+        for (const auto& tab : stats.tabs) {
+            if (tab.id == id) {
+                return &tab;
+            }
+        }
+        return nullptr;
+    };
+    const auto shard_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    stats = dbgvis::GetVisualizerStats();
+    while ((!shard("Shard 7") || !shard("Shard 3")) && std::chrono::steady_clock::now() < shard_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = dbgvis::GetVisualizerStats();
+    }
+    // Shard 3 only keeps what followed the clear.
+    const dbgvis::TabStats* kept = shard("Shard 7");
+    const dbgvis::TabStats* cleared = shard("Shard 3");
+    if (!kept || kept->scalars != 8 || kept->graphs != 1 || !cleared || cleared->scalars != 1 ||
+        cleared->graphs != 0) {
+        return 7;
+    }
+
+    // A reader sees the tab as of a whole flush; a later flush that leaves
+    // the graph alone shares its samples.
+    dbgvis::TabReader reader("Shard 7");
+    const auto snapshot_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    std::shared_ptr<const dbgvis::TabSnapshot> first = reader.get();
+    while (!first && std::chrono::steady_clock::now() < snapshot_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        first = reader.get();
+    }
+    std::shared_ptr<const std::vector<float>> samples = first ? first->get_graph_samples("samples") : nullptr;
+    if (!first || first->scalars.size() != 8 || !samples || samples->size() != 240 || samples->back() != 3999.0f) {
+        return 8;
+    }
+    dbgvis::value("Shard 7", "key 7", -1);
+    std::shared_ptr<const dbgvis::TabSnapshot> second = reader.get();
+    while (second->version == first->version && std::chrono::steady_clock::now() < snapshot_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        second = reader.get();
+    }
+    auto key7 = second->get_scalar("key 7");
+    if (second->version != first->version + 1 || !key7 || std::get<int64_t>(*key7) != -1 ||
+        second->get_graph_samples("samples") != samples) {
+        return 8;
+    }
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    // A deferred window leaves the service running and flushing without one;
+    // this target links no windowed backend, so asking for it changes nothing.
+    dbgvis::DebugVisualizerAppOptions deferred;
+    deferred.defer_window = true;
+    deferred.headless_update_hz = 200.0f;
+    dbgvis::StartBackgroundVisualizer(deferred);
+    if (!dbgvis::IsBackgroundVisualizerRunning()) {
+        return 9;
+    }
+    dbgvis::value("Deferred", "before", 1);
+    dbgvis::ShowBackgroundVisualizerWindow();
+    dbgvis::value("Deferred", "after", 2);
+    dbgvis::TabReader deferred_reader("Deferred");
+    const auto deferred_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    std::shared_ptr<const dbgvis::TabSnapshot> late = deferred_reader.get();
+    while ((!late || late->scalars.size() != 2) && std::chrono::steady_clock::now() < deferred_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        late = deferred_reader.get();
+    }
+    if (!late || late->scalars.size() != 2 || !dbgvis::IsBackgroundVisualizerRunning()) {
+        return 9;
+    }
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    // Coalescing keeps the last value and the last structure per key, while
+    // the graph samples between them all arrive in order.
+    dbgvis::DebugVisualizerAppOptions coalescing;
+    coalescing.headless = true;
+    coalescing.headless_update_hz = 200.0f;
+    coalescing.coalesce_updates = true;
+    dbgvis::StartBackgroundVisualizer(coalescing);
+    dbgvis::TabReader coalesced("Coalesced");
+    std::atomic<int> builds{0};
+    std::atomic<int> built{-1};
+    const dbgvis::Key named_last = dbgvis::register_value("Coalesced", "named last");
+    const dbgvis::Key handle_last = dbgvis::register_value("Coalesced", "handle last");
+    {
+        Gate gate;
+        // Handle and name writes to one key coalesce together.
+        dbgvis::value("Coalesced", "named last", 1);
+        dbgvis::value(named_last, 2);
+        dbgvis::value("Coalesced", "named last", 3);
+        dbgvis::value(handle_last, 1);
+        dbgvis::value("Coalesced", "handle last", 2);
+        dbgvis::value(handle_last, 3);
+        for (int i = 0; i < 100; ++i) {
+            dbgvis::value("Coalesced", "value", i);
+            dbgvis::graph_sample("Coalesced", "samples", static_cast<float>(i));
+            dbgvis::structure("Coalesced", "tree", [&builds, &built, i](dbgvis::StructureBuilder& builder) {
+                ++builds;
+                built.store(i);
+                builder.field("i", i);
+            });
+        }
+        gate.release();
+    }
+    if (!WaitFor([&] {
+            auto snapshot = coalesced.get();
+            return snapshot && snapshot->get_graph_samples("samples") &&
+                   snapshot->get_graph_samples("samples")->size() == 100;
+        })) {
+        return 10;
+    }
+    std::shared_ptr<const dbgvis::TabSnapshot> merged = coalesced.get();
+    std::shared_ptr<const std::vector<float>> ordered = merged->get_graph_samples("samples");
+    for (size_t i = 0; i < ordered->size(); ++i) {
+        if ((*ordered)[i] != static_cast<float>(i)) {
+            return 10;
+        }
+    }
+    auto last_value = merged->get_scalar("value");
+    if (!last_value || std::get<int64_t>(*last_value) != 99 || builds.load() != 1 || built.load() != 99) {
+        return 10;
+    }
+    for (const char* key : {"named last", "handle last"}) {
+        auto mixed = merged->get_scalar(key);
+        if (!mixed || std::get<int64_t>(*mixed) != 3) {
+            return 10;
+        }
+    }
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    // Bounded queues: 100 keys published into room for 10.
+    const auto publish_keys = [](const std::string& tab, int count) {
+        for (int i = 0; i < count; ++i) {
+            dbgvis::value(tab, "k" + std::to_string(i), i);
+        }
+    };
+    const auto has_keys = [](const dbgvis::TabSnapshot& snapshot, int first, int last) {
+        if (snapshot.scalars.size() != static_cast<size_t>(last - first)) {
+            return false;
+        }
+        for (int i = first; i < last; ++i) {
+            if (!snapshot.get_scalar("k" + std::to_string(i))) {
+                return false;
+            }
+        }
+        return true;
+    };
+    dbgvis::DebugVisualizerAppOptions bounded;
+    bounded.headless = true;
+    bounded.headless_update_hz = 200.0f;
+    bounded.update_queue_capacity = 10;
+
+    bounded.queue_overflow_policy = dbgvis::QueueOverflowPolicy::kDropNewest;
+    dbgvis::StartBackgroundVisualizer(bounded);
+    {
+        dbgvis::TabReader newest("Newest");
+        const uint64_t dropped = dbgvis::DroppedUpdateCount();
+        {
+            Gate gate;
+            publish_keys("Newest", 100);
+            gate.release();
+        }
+        if (!WaitFor([&] {
+                return newest.get() != nullptr;
+            }) ||
+            !has_keys(*newest.get(), 0, 10) || dbgvis::DroppedUpdateCount() - dropped != 90) {
+            return 11;
+        }
+    }
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    // Dropping the oldest record must also drop it from the coalescing index,
+    // or a later update for another key lands in the wrong slot.
+    bounded.queue_overflow_policy = dbgvis::QueueOverflowPolicy::kDropOldest;
+    bounded.coalesce_updates = true;
+    dbgvis::StartBackgroundVisualizer(bounded);
+    {
+        dbgvis::TabReader oldest("Oldest");
+        const uint64_t dropped = dbgvis::DroppedUpdateCount();
+        {
+            Gate gate;
+            publish_keys("Oldest", 100);
+            for (int i = 99; i >= 90; --i) {
+                dbgvis::value("Oldest", "k" + std::to_string(i), -i);
+            }
+            dbgvis::value("Oldest", "k0", 0);
+            gate.release();
+        }
+        if (!WaitFor([&] {
+                return oldest.get() != nullptr;
+            })) {
+            return 12;
+        }
+        std::shared_ptr<const dbgvis::TabSnapshot> kept = oldest.get();
+        auto k0 = kept->get_scalar("k0");
+        auto k95 = kept->get_scalar("k95");
+        if (kept->scalars.size() != 10 || !k0 || !k95 || std::get<int64_t>(*k95) != -95 || kept->get_scalar("k90") ||
+            dbgvis::DroppedUpdateCount() - dropped != 91) {
+            return 12;
+        }
+    }
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    // A clear_tab() is neither dropped nor counted against the bound.
+    bounded.coalesce_updates = false;
+    dbgvis::StartBackgroundVisualizer(bounded);
+    {
+        dbgvis::TabReader barrier("Barrier");
+        dbgvis::value("Barrier", "stale", 1);
+        if (!WaitFor([&] {
+                auto snapshot = barrier.get();
+                return snapshot && snapshot->get_scalar("stale");
+            })) {
+            return 15;
+        }
+        const uint64_t dropped = dbgvis::DroppedUpdateCount();
+        {
+            Gate gate;
+            dbgvis::clear_tab("Barrier");
+            publish_keys("Barrier", 100);
+            gate.release();
+        }
+        if (!WaitFor([&] {
+                auto snapshot = barrier.get();
+                return snapshot && snapshot->get_scalar("k99");
+            })) {
+            return 15;
+        }
+        std::shared_ptr<const dbgvis::TabSnapshot> cleared = barrier.get();
+        if (cleared->get_scalar("stale") || !has_keys(*cleared, 90, 100) ||
+            dbgvis::DroppedUpdateCount() - dropped != 90) {
+            return 15;
+        }
+    }
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    // kBlock holds producers back until the service drains, but a publish
+    // from the service thread itself goes through.
+    bounded.queue_overflow_policy = dbgvis::QueueOverflowPolicy::kBlock;
+    bounded.coalesce_updates = false;
+    dbgvis::StartBackgroundVisualizer(bounded);
+    {
+        dbgvis::TabReader blocked("Blocked");
+        dbgvis::TabReader reentrant("Reentrant");
+        const uint64_t dropped = dbgvis::DroppedUpdateCount();
+        std::atomic<bool> published{false};
+        std::thread producer;
+        {
+            Gate gate;
+            producer = std::thread([&] {
+                publish_keys("Blocked", 100);
+                published.store(true);
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (published.load()) {
+                gate.release();
+                producer.join();
+                return 13;
+            }
+            gate.release();
+        }
+        producer.join();
+        dbgvis::structure("Reentrant", "builder", [&publish_keys](dbgvis::StructureBuilder&) {
+            publish_keys("Reentrant", 100);
+        });
+        if (!WaitFor([&] {
+                auto all = blocked.get();
+                auto inner = reentrant.get();
+                return all && all->scalars.size() == 100 && inner && inner->scalars.size() == 100;
+            }) ||
+            dbgvis::DroppedUpdateCount() != dropped) {
+            return 13;
+        }
+    }
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    // add() never posts, so the constructor has to start the service.
+    {
+        dbgvis::Counter late("Late", "count");
+        late.add();
+        if (!WaitUntilRunning()) {
+            return 14;
+        }
+    }
+    dbgvis::ShutdownBackgroundVisualizer();
+    return 0;
+}
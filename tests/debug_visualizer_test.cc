@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <string>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "debug_visualizer/debug_visualizer.h"
 
@@ -33,6 +37,155 @@ int main() {
         return 2;
     }
 
+    graph_config.max_samples = 2;
+    metrics_tab.Graph["fps"].configure(graph_config);
+    const auto& fps = metrics_tab.Graph["fps"];
+    if (fps.size() != 2 || fps.sample(0) != 61.0f || fps.sample(1) != 62.0f || fps.offset() != 0) {
+        return 9;
+    }
+    if (fps.min_sample() != 61.0f || fps.max_sample() != 62.0f) {
+        return 10;
+    }
+
+    dbgvis::GraphConfig lod_config;
+    lod_config.max_samples = 1024;
+    lod_config.level_of_detail = true;
+    auto& latency = metrics_tab.addGraph("latency", lod_config);
+    for (int i = 0; i < 1024; ++i) {
+        latency.push(static_cast<float>(i));
+    }
+    if (latency.lod_levels() < 2 || latency.lod_bucket_count(1) != 512 ||
+        latency.lod_bucket(1, 0) != std::make_pair(0.0f, 1.0f)) {
+        return 11;
+    }
+
+    // A one-sample spike in a long graph is among the points drawn for it,
+    // and those points fit the plot width.
+    dbgvis::GraphConfig spike_config;
+    spike_config.max_samples = 1 << 16;
+    spike_config.level_of_detail = true;
+    auto& spiky = metrics_tab.addGraph("spiky", spike_config);
+    for (int i = 0; i < (1 << 16); ++i) {
+        spiky.push(i == 40001 ? 100.0f : 0.0f);
+    }
+    std::vector<float> plotted;
+    spiky.plot_values(300, plotted);
+    if (spiky.plot_level(300) == 0 || plotted.empty() || plotted.size() > 300 ||
+        std::count(plotted.begin(), plotted.end(), 100.0f) != 1) {
+        return 20;
+    }
+
+    // Block ingestion must match pushing the same samples one at a time,
+    // across ring wraparound and blocks longer than the ring.
+    dbgvis::GraphConfig bulk_config;
+    bulk_config.max_samples = 64;
+    bulk_config.level_of_detail = true;
+    auto& bulk = metrics_tab.addGraph("bulk", bulk_config);
+    auto& reference = metrics_tab.addGraph("reference", bulk_config);
+    std::vector<float> block;
+    float next = 0.0f;
+    for (size_t length : {10u, 50u, 30u, 200u, 7u, 63u}) {
+        block.clear();
+        for (size_t i = 0; i < length; ++i) {
+            block.push_back(std::sin(next += 1.0f));
+            reference.push(block.back());
+        }
+        bulk.add_samples(block.data(), block.size());
+        if (bulk.size() != reference.size() || bulk.min_sample() != reference.min_sample() ||
+            bulk.max_sample() != reference.max_sample() || bulk.latest() != reference.latest()) {
+            return 15;
+        }
+        for (size_t i = 0; i < bulk.size(); ++i) {
+            if (bulk.sample(i) != reference.sample(i)) {
+                return 15;
+            }
+        }
+        for (size_t level = 1; level < bulk.lod_levels(); ++level) {
+            for (size_t i = 0; i < bulk.lod_bucket_count(level); ++i) {
+                if (bulk.lod_bucket_count(level) != reference.lod_bucket_count(level) ||
+                    bulk.lod_bucket(level, i) != reference.lod_bucket(level, i)) {
+                    return 15;
+                }
+            }
+        }
+    }
+    auto& adopted = metrics_tab.addGraph("adopted", bulk_config);
+    std::vector<float> owned(40, 2.0f);
+    const float* buffer = owned.data();
+    adopted.add_samples(std::move(owned));
+    if (adopted.size() != 40 || adopted.data() != buffer || adopted.max_sample() != 2.0f) {
+        return 15;
+    }
+
+    // Rows older than the time window behind the newest one are evicted,
+    // independently of how often they arrived.
+    dbgvis::TimeSeriesConfig series_config;
+    series_config.series = {"left", "right"};
+    series_config.time_window = 1.0;
+    series_config.max_samples = 16;
+    metrics_tab.configure_series("wheels", series_config);
+    for (int i = 0; i < 10; ++i) {
+        metrics_tab.push_series_sample("wheels", 0.1 * i, {static_cast<float>(i), -static_cast<float>(i)});
+    }
+    metrics_tab.push_series_sample("wheels", 1.55, {20.0f});
+    const dbgvis::DebugVisualizer::TimeSeries* wheels = metrics_tab.find_series("wheels");
+    if (!wheels || wheels->size() != 5 || wheels->value(0, 0) != 6.0f || !std::isnan(wheels->value(1, 4)) ||
+        wheels->min_value() != -9.0f || wheels->max_value() != 20.0f || wheels->series_label(1) != "right") {
+        return 16;
+    }
+    series_config.time_window = 0.0;
+    series_config.max_samples = 3;
+    metrics_tab.configure_series("wheels", series_config);
+    metrics_tab.push_series_sample("wheels", 1.0, {30.0f, 1.0f});
+    if (wheels->size() != 3 || wheels->time(2) != 1.55 || wheels->value(0, 0) != 9.0f ||
+        wheels->max_value() != 30.0f || wheels->min_value() != -9.0f) {
+        return 16;
+    }
+
+    // Quantiles stay within the relative accuracy, merging is exact, and
+    // the bucket count follows the value range rather than the event count.
+    dbgvis::QuantileSketch latencies;
+    dbgvis::QuantileSketch odd;
+    for (int i = 1; i <= 100000; ++i) {
+        latencies.add(i);
+        if (i % 2 == 1) {
+            odd.add(i);
+        }
+    }
+    const size_t buckets = latencies.counts().size();
+    for (int i = 0; i < 100000; ++i) {
+        latencies.add(1 + i % 100000);
+    }
+    dbgvis::QuantileSketch merged;
+    merged.add(0.0, 3);
+    if (std::abs(latencies.quantile(0.99) - 99000.0) > 990.0 || std::abs(latencies.quantile(0.5) - 50000.0) > 500.0 ||
+        latencies.counts().size() != buckets || latencies.min() != 1.0 || latencies.max() != 100000.0 ||
+        !merged.merge(odd) || merged.count() != 50003 || merged.quantile(0.0) != 0.0 ||
+        metrics_tab.add_histogram_sample("rtt", 2.0).find_histogram("rtt")->count() != 1) {
+        return 17;
+    }
+    dbgvis::HistogramConfig coarse;
+    coarse.relative_accuracy = 0.05;
+    if (merged.merge(dbgvis::QuantileSketch(coarse)) ||
+        metrics_tab.merge_histogram("rtt", latencies).find_histogram("rtt")->count() != 200001) {
+        return 17;
+    }
+
+    // Zones whose end falls out of the window are dropped; lanes grow to the
+    // deepest nesting seen.
+    dbgvis::DebugVisualizer::ZoneTimeline& zones = metrics_tab.zone_timeline("zones");
+    zones = dbgvis::DebugVisualizer::ZoneTimeline(1.0);
+    const uint32_t main_lane = zones.lane_id("main");
+    const uint32_t frame = zones.name_id("Frame");
+    const uint32_t cull = zones.name_id("Cull");
+    zones.push({main_lane, cull, 1, 0.1, 0.2});
+    zones.push({main_lane, frame, 0, 0.0, 0.5});
+    zones.push({main_lane, frame, 0, 1.0, 1.4});
+    if (zones.name_id("Cull") != cull || zones.size() != 2 || zones.zones().front().name != frame ||
+        zones.lane_depth(main_lane) != 2 || zones.latest_time() != 1.4 || !metrics_tab.find_zone_timeline("zones")) {
+        return 18;
+    }
+
     metrics_tab.update_structure("player", [](dbgvis::StructureBuilder& builder) {
         builder.field("health", 97);
         builder.field("mana", 44);
@@ -47,6 +200,28 @@ int main() {
         return 3;
     }
 
+    dbgvis::StructureTree tree;
+    const auto publish = [&](bool with_mana) {
+        tree.update([&](dbgvis::StructureBuilder& builder) {
+            builder.field("health", 97);
+            if (with_mana) {
+                builder.field("mana", 44);
+            }
+            builder.nested("position").field("x", 1.0f);
+        });
+    };
+    publish(true);
+    const uint32_t health = tree.root().first_child;
+    publish(true);
+    if (tree.size() != 4 || tree.root().first_child != health) {
+        return 13;
+    }
+    publish(false);
+    const dbgvis::StructureNode shrunk = tree.snapshot();
+    if (tree.size() != 3 || shrunk.children.size() != 2 || shrunk.children[1].label != "position") {
+        return 13;
+    }
+
     auto& ai_tile = visualizer.window_tile("ai", "AI Debug");
     auto& ai_tab = ai_tile.tabs["state"];
     ai_tab.update_value("state", "searching");
@@ -67,5 +242,68 @@ int main() {
         return 6;
     }
 
+    dbgvis::DebugVisualizer background;
+    background.set_defer_hidden_structures(true);
+    background.set_visible(false);
+    background.render();
+    int builds = 0;
+    const auto build = [&builds](dbgvis::StructureBuilder& builder) {
+        builder.field("builds", ++builds);
+    };
+    dbgvis::DebugVisualizer::Tab& hidden = background.default_tab();
+    hidden.defer_structure("stats", build);
+    hidden.defer_structure("stats", build);
+    if (hidden.is_shown() || builds != 0) {
+        return 14;
+    }
+    background.set_defer_hidden_structures(false);
+    if (!hidden.is_shown() || builds != 1 || !hidden.get_structure("stats")) {
+        return 14;
+    }
+
+    auto& net_tab = visualizer.tabs["net"];
+    dbgvis::DebugVisualizer::ScalarEntry& rx_bytes = net_tab.scalar_slot("rx_bytes");
+    rx_bytes.set(int64_t{1024});
+    auto rx = net_tab.get_scalar("rx_bytes");
+    if (!rx || std::get<int64_t>(*rx) != 1024) {
+        return 7;
+    }
+    rx_bytes.dirty = false;
+    net_tab.update_value("rx_bytes", int64_t{1024});
+    if (rx_bytes.dirty) {
+        return 12;
+    }
+    net_tab.update_value("rx_bytes", int64_t{2048});
+    if (!rx_bytes.dirty) {
+        return 12;
+    }
+    const uint64_t generation = net_tab.generation();
+    net_tab.clear();
+    if (net_tab.generation() == generation || net_tab.get_scalar("rx_bytes")) {
+        return 8;
+    }
+
+    // Lookups are indexed, but tabs and tiles keep their insertion order
+    // across removals and re-adds.
+    dbgvis::DebugVisualizer sharded;
+    for (int i = 0; i < 300; ++i) {
+        sharded.add_tab("shard " + std::to_string(i));
+        sharded.window_tile("tile " + std::to_string(i % 3));
+    }
+    if (!sharded.remove_tab("shard 7") || sharded.remove_tab("shard 7") || sharded.find_tab("shard 7") ||
+        !sharded.remove_window_tile("tile 0") || sharded.find_window_tile("tile 0")) {
+        return 19;
+    }
+    sharded.add_tab("shard 7").update_value("back", 1);
+    sharded.window_tile("tile 0");
+    const std::vector<std::string> shard_ids = sharded.tab_ids();
+    const std::vector<std::string> tile_ids = sharded.window_tile_ids();
+    if (shard_ids.size() != 301 || shard_ids[0] != "overview" || shard_ids[7] != "shard 6" ||
+        shard_ids[8] != "shard 8" || shard_ids.back() != "shard 7" || !sharded.find_tab("shard 7")->get_scalar("back") ||
+        tile_ids != std::vector<std::string>{"tile 1", "tile 2", "tile 0"} ||
+        &sharded.window_tile("tile 2") != sharded.find_window_tile("tile 2")) {
+        return 19;
+    }
+
     return 0;
 }
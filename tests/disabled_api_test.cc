@@ -0,0 +1,75 @@
+// Call sites of the publishing API, built against :debug_visualizer_disabled
+// so the compiled-out signatures keep accepting what the enabled ones do.
+
+#include <string>
+#include <vector>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+#if DBGVIS_ENABLED
+#error "disabled_api_test must build with DBGVIS_ENABLED=0"
+#endif
+
+int main() {
+    dbgvis::DebugVisualizerAppOptions options;
+    options.headless = true;
+    dbgvis::StartBackgroundVisualizer(options);
+    dbgvis::StartBackgroundVisualizer(true);
+    dbgvis::StartBackgroundVisualizer();
+
+    const std::string tab = "Telemetry";
+    const dbgvis::TabHandle handle = dbgvis::register_tab(tab);
+    const dbgvis::Key frame = dbgvis::register_value(handle, "frame");
+    const dbgvis::Key fps = dbgvis::register_graph("Telemetry", "fps", {});
+    dbgvis::value(frame, 1);
+    dbgvis::value(frame, std::string("one"));
+    dbgvis::graph_sample(fps, 60.0f);
+
+    dbgvis::value(tab, "int", 1);
+    dbgvis::value("Telemetry", "double", 0.5);
+    dbgvis::value("Telemetry", "text", "hello");
+    dbgvis::value("Telemetry", "string", std::string("hello"));
+    dbgvis::value("flag", true);
+    dbgvis::graph_sample("Telemetry", "fps", 60.0f, {});
+    dbgvis::graph_sample("fps", 60.0f);
+    const std::vector<float> samples = {1.0f, 2.0f};
+    dbgvis::graph_samples("Telemetry", "block", samples, {});
+    dbgvis::graph_samples("Telemetry", "block", std::vector<float>{3.0f});
+    dbgvis::graph_samples("Telemetry", "block", samples.data(), samples.size());
+    dbgvis::configure_series("Telemetry", "series", {});
+    dbgvis::series_sample("Telemetry", "series", {1.0f, 2.0f});
+    dbgvis::series_sample("series", {1.0f, 2.0f});
+    dbgvis::histogram("Telemetry", "latency", 1.5, {});
+    dbgvis::histogram("latency", 1.5);
+    dbgvis::flush_histograms();
+    dbgvis::structure("Telemetry", "tree", [](dbgvis::StructureBuilder& builder) {
+        builder.field("x", 1);
+    });
+    dbgvis::structure("tree", {});
+    dbgvis::clear_tab("Telemetry");
+    dbgvis::clear_tab();
+    dbgvis::set_window_title("title");
+    dbgvis::show_window(false);
+
+    dbgvis::Counter counter("Net", "packets");
+    counter.add();
+    dbgvis::Gauge gauge(tab, "load");
+    gauge.set(0.5);
+    dbgvis::TabReader reader("Telemetry");
+
+    DBGVIS_VALUE("Telemetry", "macro", 1);
+    DBGVIS_GRAPH_SAMPLE("Telemetry", "fps", 60.0f, {});
+    DBGVIS_HISTOGRAM("latency", 1.5);
+    {
+        DBGVIS_SCOPE("Zone");
+    }
+    dbgvis::flush_zones();
+    dbgvis::ShowBackgroundVisualizerWindow();
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    if (dbgvis::IsBackgroundVisualizerRunning() || counter.valid() || gauge.valid() || reader.get() ||
+        dbgvis::DroppedUpdateCount() != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "debug_visualizer/debug_visualizer.h"
+#include "debug_visualizer/recording.h"
+
+namespace {
+bool WaitUntilRunning() {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!dbgvis::IsBackgroundVisualizerRunning()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+std::string TempPath(const char* name) {
+    const char* dir = std::getenv("TEST_TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/" + name;
+}
+
+int64_t Counter(const dbgvis::DebugVisualizer& tile) {
+    const dbgvis::DebugVisualizer::Tab* tab = tile.find_tab("Telemetry");
+    auto value = tab ? tab->get_scalar("counter") : std::nullopt;
+    return value ? std::get<int64_t>(*value) : -1;
+}
+}  // namespace
+
+int main() {
+    const std::string path = TempPath("dbgvis_recording_test.rec");
+
+    dbgvis::DebugVisualizerAppOptions options;
+    options.headless = true;
+    options.headless_update_hz = 500.0f;
+    options.record_path = path;
+    options.record_keyframe_interval = 4;
+    dbgvis::StartBackgroundVisualizer(options);
+    if (!WaitUntilRunning()) {
+        return 1;
+    }
+
+    dbgvis::Counter ticks("Telemetry", "ticks");
+    for (int i = 0; i < 40; ++i) {
+        ticks.add();
+        dbgvis::value("Telemetry", "counter", i);
+        dbgvis::graph_sample("Telemetry", "ramp", static_cast<float>(i));
+        dbgvis::series_sample("Telemetry", "pair", {static_cast<float>(i), static_cast<float>(2 * i)});
+        dbgvis::histogram("Latency", "request", i + 1.0);
+        dbgvis::structure("Telemetry", "state", [i](dbgvis::StructureBuilder& builder) {
+            builder.nested("inner").field("i", i);
+        });
+        if (i == 20) {
+            dbgvis::clear_tab("Telemetry");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    }
+    dbgvis::flush_histograms();
+    // The counter is read once per frame rather than queued.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    dbgvis::ShutdownBackgroundVisualizer();
+
+    auto reader = dbgvis::RecordingReader::open(path);
+    if (!reader || reader->tile_id() != "Main" || reader->frame_count() < 2 || reader->keyframe_count() < 1) {
+        return 2;
+    }
+
+    // Each frame reached by stepping must match a cold seek to it.
+    dbgvis::DebugVisualizer stepped;
+    std::vector<int64_t> counters;
+    for (uint64_t frame = 0; frame < reader->frame_count(); ++frame) {
+        if (!reader->seek(frame, stepped)) {
+            return 3;
+        }
+        counters.push_back(Counter(stepped));
+    }
+    if (counters.back() != 39) {
+        return 4;
+    }
+    const dbgvis::DebugVisualizer::Tab* tab = stepped.find_tab("Telemetry");
+    auto ticks_value = tab ? tab->get_scalar("ticks") : std::nullopt;
+    if (!tab || tab->get_graph_samples("ramp").size() != 19 || !tab->get_structure("state") || !ticks_value ||
+        std::get<int64_t>(*ticks_value) != 40) {
+        return 4;
+    }
+    const dbgvis::DebugVisualizer::TimeSeries* pair = tab->find_series("pair");
+    if (!pair || pair->size() != 19 || pair->series_count() != 2 || pair->value(1, 18) != 78.0f ||
+        pair->time(0) > pair->time(18)) {
+        return 4;
+    }
+    const dbgvis::DebugVisualizer::Tab* latency = stepped.find_tab("Latency");
+    const dbgvis::QuantileSketch* request = latency ? latency->find_histogram("request") : nullptr;
+    if (!request || request->count() != 40 || request->max() != 40.0 || std::abs(request->quantile(0.5) - 20.0) > 0.2) {
+        return 4;
+    }
+    for (uint64_t frame = reader->frame_count(); frame-- > 0;) {
+        dbgvis::DebugVisualizer cold;
+        if (!reader->seek(frame, cold) || Counter(cold) != counters[frame]) {
+            return 5;
+        }
+        const dbgvis::DebugVisualizer::Tab* cold_latency = cold.find_tab("Latency");
+        const dbgvis::QuantileSketch* cold_request = cold_latency ? cold_latency->find_histogram("request") : nullptr;
+        if (frame + 1 == reader->frame_count() && (!cold_request || cold_request->count() != 40)) {
+            return 5;
+        }
+    }
+
+    // Without the footer the index is rebuilt by scanning.
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    std::vector<char> bytes;
+    if (file) {
+        char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            bytes.insert(bytes.end(), buffer, buffer + n);
+        }
+        std::fclose(file);
+    }
+    const std::string truncated_path = TempPath("dbgvis_recording_test_truncated.rec");
+    file = std::fopen(truncated_path.c_str(), "wb");
+    if (!file || bytes.size() < 32) {
+        return 6;
+    }
+    std::fwrite(bytes.data(), 1, bytes.size() - 32, file);
+    std::fclose(file);
+    auto scanned = dbgvis::RecordingReader::open(truncated_path);
+    dbgvis::DebugVisualizer rebuilt;
+    if (!scanned || scanned->frame_count() != reader->frame_count() ||
+        scanned->keyframe_count() != reader->keyframe_count() ||
+        !scanned->seek(scanned->frame_count() - 1, rebuilt) || Counter(rebuilt) != 39) {
+        return 6;
+    }
+
+    std::remove(path.c_str());
+    std::remove(truncated_path.c_str());
+
+    // A structure published while its window is hidden is built once, on
+    // show, whether or not a recording is open.
+    const std::string hidden_path = TempPath("dbgvis_recording_test_hidden.rec");
+    options.record_path = hidden_path;
+    options.defer_hidden_structures = true;
+    dbgvis::StartBackgroundVisualizer(options);
+    if (!WaitUntilRunning()) {
+        return 7;
+    }
+    dbgvis::show_window(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    static std::atomic<int> builds{0};
+    for (int i = 0; i < 10; ++i) {
+        dbgvis::structure("Hidden", "state", [i](dbgvis::StructureBuilder& builder) {
+            builds.fetch_add(1);
+            builder.field("i", i);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (builds.load() != 0) {
+        return 7;
+    }
+    dbgvis::show_window(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // The second value lands after the thread's first post and is only
+    // posted by the service, since the thread outlives the recording.
+    std::atomic<bool> recorded{false};
+    std::atomic<bool> stop{false};
+    std::thread idle([&recorded, &stop] {
+        dbgvis::histogram("Hidden", "idle", 1.0);
+        dbgvis::histogram("Hidden", "idle", 2.0);
+        recorded.store(true);
+        while (!stop.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    while (!recorded.load()) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    dbgvis::ShutdownBackgroundVisualizer();
+    stop.store(true);
+    idle.join();
+    if (builds.load() != 1) {
+        return 7;
+    }
+    auto hidden_reader = dbgvis::RecordingReader::open(hidden_path);
+    dbgvis::DebugVisualizer shown;
+    if (!hidden_reader || !hidden_reader->seek(hidden_reader->frame_count() - 1, shown)) {
+        return 8;
+    }
+    const dbgvis::DebugVisualizer::Tab* hidden_tab = shown.find_tab("Hidden");
+    auto state = hidden_tab ? hidden_tab->get_structure("state") : std::nullopt;
+    if (!state || state->children.size() != 1 || state->children[0].label != "i" || !state->children[0].value ||
+        *state->children[0].value != dbgvis::ScalarValue{int64_t{9}}) {
+        return 8;
+    }
+    const dbgvis::QuantileSketch* idle_sketch = hidden_tab->find_histogram("idle");
+    if (!idle_sketch || idle_sketch->count() != 2) {
+        return 9;
+    }
+    std::remove(hidden_path.c_str());
+    return 0;
+}
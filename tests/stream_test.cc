@@ -0,0 +1,123 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "debug_visualizer/debug_visualizer.h"
+
+namespace {
+template <typename Predicate>
+bool WaitFor(Predicate predicate) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+std::string TempPath(const char* name) {
+    const char* dir = std::getenv("TEST_TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/" + name;
+}
+
+// Written by the viewer's update callback, read by the test.
+struct ViewerState {
+    std::atomic<int64_t> counter{-1};
+    std::atomic<size_t> ramp_samples{0};
+    std::atomic<bool> has_structure{false};
+    std::atomic<bool> disconnected{false};
+    std::atomic<bool> quit{false};
+};
+
+// Publishes through `stream_address` to a viewer listening at
+// `listen_address`; 0 on success.
+int RunTransport(const std::string& stream_address, const std::string& listen_address, const std::string& name) {
+    // The producer starts before any viewer is listening; publishing must
+    // not wait for one.
+    dbgvis::DebugVisualizerAppOptions producer;
+    producer.headless = true;
+    producer.headless_update_hz = 200.0f;
+    producer.stream_address = stream_address;
+    producer.stream_name = name;
+    producer.shm_ring_capacity = 256u << 10;
+    dbgvis::StartBackgroundVisualizer(producer);
+    if (!WaitFor([] { return dbgvis::IsBackgroundVisualizerRunning(); })) {
+        return 1;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+        dbgvis::value("Telemetry", "counter", i);
+    }
+    if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(100)) {
+        return 2;
+    }
+
+    ViewerState state;
+    std::thread viewer([&] {
+        dbgvis::DebugVisualizerAppOptions options;
+        options.headless = true;
+        options.headless_update_hz = 200.0f;
+        options.listen_address = listen_address;
+        dbgvis::DebugVisualizerApp app(options);
+        app.run([&](dbgvis::DebugVisualizerApp& ctx, float, float) {
+            if (state.quit.load()) {
+                ctx.request_close();
+            }
+            const dbgvis::DebugVisualizer* tile = ctx.findTile(name);
+            const dbgvis::DebugVisualizer::Tab* tab = tile ? tile->find_tab("Telemetry") : nullptr;
+            if (!tab) {
+                return;
+            }
+            auto counter = tab->get_scalar("counter");
+            state.counter.store(counter ? std::get<int64_t>(*counter) : -1);
+            state.ramp_samples.store(tab->get_graph_samples("ramp").size());
+            state.has_structure.store(tab->get_structure("state").has_value());
+            state.disconnected.store(tile->window_title().find("(disconnected)") != std::string::npos);
+        });
+    });
+
+    // The producer connects (or sees the viewer attach) and resynchronises
+    // from a keyframe, so values published while no one listened arrive.
+    int result = 0;
+    if (!WaitFor([&] { return state.counter.load() == 9; })) {
+        result = 3;
+    }
+
+    for (int i = 10; i < 50 && result == 0; ++i) {
+        dbgvis::value("Telemetry", "counter", i);
+        dbgvis::graph_samples("Telemetry", "ramp", {static_cast<float>(i), static_cast<float>(i) + 0.5f});
+        dbgvis::structure("Telemetry", "state", [i](dbgvis::StructureBuilder& builder) {
+            builder.field("i", i);
+        });
+    }
+    if (result == 0 && !WaitFor([&] {
+            return state.counter.load() == 49 && state.ramp_samples.load() == 80 && state.has_structure.load();
+        })) {
+        result = 4;
+    }
+
+    dbgvis::ShutdownBackgroundVisualizer();
+    if (result == 0 && !WaitFor([&] { return state.disconnected.load(); })) {
+        result = 5;
+    }
+
+    state.quit.store(true);
+    viewer.join();
+    return result;
+}
+}  // namespace
+
+int main() {
+    if (int result = RunTransport("unix:" + TempPath("dbgvis_stream_test.sock"),
+                                  "unix:" + TempPath("dbgvis_stream_test.sock"), "socket producer")) {
+        return result;
+    }
+    if (int result = RunTransport("shm:", "shm:dbgvis_stream_test", "dbgvis_stream_test/shm producer")) {
+        return 10 + result;
+    }
+    return 0;
+}